@@ -0,0 +1,534 @@
+/**
+ * @file ScalingBenchmark.cpp
+ * @author Subnite
+ * @brief runs many processors in a host like graph, and reports how they scale with the amount of instances and threads.
+ *
+ * Every instance gets its own noise and note ons, the ones of a block cycle are spread over a pool of workers that
+ * take the next instance until all of them are done, like a host spreads its tracks over its audio threads.
+ * The thread that starts a cycle works on it too.
+ *
+ * usage: H-Duck-Benchmark [--instances=1,2,4,...,512] [--threads=1,2,...] [--seconds=2] [--rate=48000] [--block=256] [--kernel=avx2] [--csv]
+ */
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#if JUCE_LINUX
+ #include <linux/perf_event.h>
+ #include <sys/syscall.h>
+ #include <unistd.h>
+#elif JUCE_MAC
+ #include <mach/mach.h>
+#elif JUCE_WINDOWS
+ #ifndef NOMINMAX
+  #define NOMINMAX
+ #endif
+ #include <windows.h>
+ #include <psapi.h>
+ #pragma comment(lib, "psapi.lib")
+#endif
+
+namespace duck::bench
+{
+    using Clock = std::chrono::steady_clock;
+
+    struct Options {
+        std::vector<int> instances{1, 2, 4, 8, 16, 32, 64, 128, 256, 512};
+        std::vector<int> threads;
+        double seconds = 2.0;
+        double sampleRate = 48000.0;
+        int blockSize = 256;
+        juce::String kernel;
+        bool csv = false;
+    };
+
+    /** @return The comma separated numbers in list, sorted and without the ones outside [minValue : maxValue]. */
+    static std::vector<int> parseList(const juce::String& list, int minValue, int maxValue)
+    {
+        std::vector<int> values;
+        for (const auto& token : juce::StringArray::fromTokens(list, ",", {})) {
+            const auto value = token.trim().getIntValue();
+            if (value >= minValue && value <= maxValue) values.push_back(value);
+        }
+        std::sort(values.begin(), values.end());
+        values.erase(std::unique(values.begin(), values.end()), values.end());
+        return values;
+    }
+
+    /** @return The memory the process has resident in bytes, 0 where that isn't known. */
+    static size_t getResidentBytes()
+    {
+       #if JUCE_LINUX
+        // the second field is the resident pages
+        const auto fields = juce::StringArray::fromTokens(juce::File("/proc/self/statm").loadFileAsString(), " ", {});
+        if (fields.size() < 2) return 0;
+        return static_cast<size_t>(fields[1].getLargeIntValue()) * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+       #elif JUCE_MAC
+        mach_task_basic_info info{};
+        mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+        if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, reinterpret_cast<task_info_t>(&info), &count) != KERN_SUCCESS) return 0;
+        return static_cast<size_t>(info.resident_size);
+       #elif JUCE_WINDOWS
+        PROCESS_MEMORY_COUNTERS counters{};
+        if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+        return static_cast<size_t>(counters.WorkingSetSize);
+       #else
+        return 0;
+       #endif
+    }
+
+    /**
+     * The cache references, cache misses and instructions of the process, user space only.
+     * Opened before any worker starts, so they inherit it. Only linux has these, and only when perf_event_paranoid allows it.
+     */
+    class CacheCounters
+    {
+    public:
+        struct Reading {
+            uint64_t references = 0, misses = 0, instructions = 0;
+        };
+
+        CacheCounters()
+        {
+           #if JUCE_LINUX
+            referencesFd = open(PERF_COUNT_HW_CACHE_REFERENCES);
+            missesFd = open(PERF_COUNT_HW_CACHE_MISSES);
+            instructionsFd = open(PERF_COUNT_HW_INSTRUCTIONS);
+           #endif
+        }
+
+        ~CacheCounters()
+        {
+           #if JUCE_LINUX
+            for (auto fd : {referencesFd, missesFd, instructionsFd})
+                if (fd >= 0) close(fd);
+           #endif
+        }
+
+        bool isValid() const { return referencesFd >= 0 && missesFd >= 0; }
+
+        /** @return The counts since the counters were opened, std::nullopt if they couldn't be. */
+        std::optional<Reading> read() const
+        {
+            if (!isValid()) return std::nullopt;
+            return Reading{readFd(referencesFd), readFd(missesFd), readFd(instructionsFd)};
+        }
+
+    private:
+       #if JUCE_LINUX
+        static int open(uint64_t config)
+        {
+            perf_event_attr attr{};
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.size = sizeof(attr);
+            attr.config = config;
+            attr.inherit = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+        }
+
+        static uint64_t readFd(int fd)
+        {
+            uint64_t value = 0;
+            if (fd < 0 || ::read(fd, &value, sizeof(value)) != static_cast<ssize_t>(sizeof(value))) return 0;
+            return value;
+        }
+       #else
+        static uint64_t readFd(int) { return 0; }
+       #endif
+
+        int referencesFd = -1;
+        int missesFd = -1;
+        int instructionsFd = -1;
+    };
+
+    /** A playing transport at a steady tempo, moved by the host loop between cycles. */
+    class SteadyPlayHead : public juce::AudioPlayHead
+    {
+    public:
+        static constexpr double bpm = 128.0;
+
+        explicit SteadyPlayHead(double sampleRate) : sampleRate(sampleRate) {}
+
+        juce::Optional<PositionInfo> getPosition() const override
+        {
+            PositionInfo info;
+            info.setIsPlaying(true);
+            info.setBpm(bpm);
+            info.setTimeInSamples(timeInSamples);
+            info.setTimeInSeconds(static_cast<double>(timeInSamples) / sampleRate);
+            info.setPpqPosition(static_cast<double>(timeInSamples) / sampleRate * bpm / 60.0);
+            return info;
+        }
+
+        // only between cycles, the workers read it while one runs.
+        void setTime(juce::int64 time) { timeInSamples = time; }
+
+    private:
+        double sampleRate;
+        juce::int64 timeInSamples = 0;
+    };
+
+    /** Noise every instance copies its input from, each at its own offset. Read only while the graph runs. */
+    class NoiseSource
+    {
+    public:
+        static constexpr int length = 1 << 16;
+
+        NoiseSource(int numChannels, int blockSize) : blockSize(blockSize), samples(numChannels, length + blockSize)
+        {
+            juce::Random random{0x4844};
+            for (int ch = 0; ch < numChannels; ch++) {
+                auto data = samples.getWritePointer(ch);
+                for (int i = 0; i < length; i++)
+                    data[i] = (random.nextFloat() * 2.f - 1.f) * 0.5f;
+                // the tail repeats the start, so a block never wraps
+                std::copy(data, data + blockSize, data + length);
+            }
+        }
+
+        void copyTo(juce::AudioBuffer<float>& buffer, juce::int64 position) const
+        {
+            const auto start = static_cast<int>(position & (length - 1));
+            const auto numSamples = std::min(buffer.getNumSamples(), blockSize);
+            for (int ch = 0; ch < buffer.getNumChannels(); ch++)
+                buffer.copyFrom(ch, 0, samples, ch % samples.getNumChannels(), start, numSamples);
+        }
+
+    private:
+        int blockSize;
+        juce::AudioBuffer<float> samples;
+    };
+
+    /** One track of the graph, its processor with the buffers the host hands it. */
+    struct Instance {
+        std::unique_ptr<HentaiDuckProcessor> processor;
+        juce::AudioBuffer<float> buffer;
+        juce::MidiBuffer midi;
+        juce::int64 noiseOffset = 0;
+        juce::int64 noteOffset = 0;   // where in the beat its note ons land, in samples
+        bool offbeats = false;        // a note on every half beat instead of every beat
+        double worstMicroseconds = 0; // of one processBlock, since the last reset
+    };
+
+    /** Makes instance index, with settings that differ a bit per index like the tracks of a real session. */
+    static std::unique_ptr<Instance> createInstance(int index, const Options& options, SteadyPlayHead& playHead)
+    {
+        auto instance = std::make_unique<Instance>();
+        instance->processor = std::make_unique<HentaiDuckProcessor>();
+        auto& processor = *instance->processor;
+
+        auto set = [&processor](params::ID id, float value) {
+            auto& parameter = processor.getParameterFor(id);
+            parameter.setValueNotifyingHost(parameter.convertTo0to1(value));
+        };
+        static constexpr float lookaheads[] = {0.f, 5.f, 10.f, 0.f};
+        set(params::ID::LENGTH_MS, 150.f + static_cast<float>(index % 7) * 50.f);
+        set(params::ID::LOOKAHEAD_MS, lookaheads[index % 4]);
+        set(params::ID::DEPTH, 80.f + static_cast<float>(index % 5) * 5.f);
+        set(params::ID::MIX, 100.f);
+        set(params::ID::COMBINE, static_cast<float>(index % 3));
+        // every fifth track follows the pattern instead of its midi
+        set(params::ID::TRIGGER, static_cast<float>(static_cast<int>(index % 5 == 4 ? dsp::TriggerSource::PATTERN : dsp::TriggerSource::MIDI)));
+
+        if (options.kernel.isNotEmpty() && !processor.setKernels(options.kernel))
+            std::fprintf(stderr, "kernel %s can't run here, using %s\n", options.kernel.toRawUTF8(), processor.getKernelName());
+
+        processor.setPlayHead(&playHead);
+        processor.setPlayConfigDetails(2, 2, options.sampleRate, options.blockSize);
+        processor.prepareToPlay(options.sampleRate, options.blockSize);
+
+        instance->buffer.setSize(2, options.blockSize);
+        instance->midi.ensureSize(256);
+        instance->noiseOffset = static_cast<juce::int64>(index) * 7919;
+        const auto beat = static_cast<juce::int64>(options.sampleRate * 60.0 / SteadyPlayHead::bpm);
+        instance->noteOffset = (static_cast<juce::int64>(index) * 131) % beat;
+        instance->offbeats = index % 2 == 1;
+        return instance;
+    }
+
+    /** Renders one block of instance at time, the way a host would call it. */
+    static void processInstance(Instance& instance, const NoiseSource& noise, juce::int64 time, double sampleRate)
+    {
+        const auto numSamples = instance.buffer.getNumSamples();
+        noise.copyTo(instance.buffer, instance.noiseOffset + time);
+
+        instance.midi.clear();
+        const auto beat = static_cast<juce::int64>(sampleRate * 60.0 / SteadyPlayHead::bpm);
+        const auto interval = instance.offbeats ? beat / 2 : beat;
+        // the first note on at or after time
+        auto note = time - ((time - instance.noteOffset) % interval + interval) % interval;
+        if (note < time) note += interval;
+        for (; note < time + numSamples; note += interval)
+            instance.midi.addEvent(juce::MidiMessage::noteOn(1, 36, static_cast<juce::uint8>(100)), static_cast<int>(note - time));
+
+        const auto start = Clock::now();
+        instance.processor->processBlock(instance.buffer, instance.midi);
+        const auto microseconds = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+        instance.worstMicroseconds = std::max(instance.worstMicroseconds, microseconds);
+    }
+
+    /**
+     * The audio threads of the host. runCycle() hands out every instance once, each worker takes the next one that
+     * nobody took yet, and returns when all of them are done.
+     */
+    class HostGraph
+    {
+    public:
+        HostGraph(int numThreads, std::function<void(int)> processFn) : process(std::move(processFn))
+        {
+            // the thread calling runCycle is the first worker
+            for (int i = 1; i < numThreads; i++)
+                workers.emplace_back([this] { run(); });
+        }
+
+        ~HostGraph()
+        {
+            {
+                std::lock_guard lock{mutex};
+                quitting = true;
+            }
+            started.notify_all();
+            for (auto& worker : workers) worker.join();
+        }
+
+        void runCycle(int amtInstances)
+        {
+            {
+                std::lock_guard lock{mutex};
+                amount = amtInstances;
+                next.store(0, std::memory_order_relaxed);
+                pending = static_cast<int>(workers.size());
+                cycle++;
+            }
+            started.notify_all();
+            work();
+
+            std::unique_lock lock{mutex};
+            finished.wait(lock, [this] { return pending == 0; });
+        }
+
+    private:
+        void run()
+        {
+            uint64_t seenCycle = 0;
+            for (;;) {
+                {
+                    std::unique_lock lock{mutex};
+                    started.wait(lock, [&] { return quitting || cycle != seenCycle; });
+                    if (quitting) return;
+                    seenCycle = cycle;
+                }
+                work();
+                std::lock_guard lock{mutex};
+                if (--pending == 0) finished.notify_one();
+            }
+        }
+
+        void work()
+        {
+            for (int i = next.fetch_add(1, std::memory_order_relaxed); i < amount; i = next.fetch_add(1, std::memory_order_relaxed))
+                process(i);
+        }
+
+        std::function<void(int)> process;
+        std::vector<std::thread> workers;
+        std::mutex mutex;
+        std::condition_variable started, finished;
+        std::atomic<int> next{0};
+        int amount = 0;   // written under the mutex before a cycle starts
+        int pending = 0;  // the workers that are still in this cycle
+        uint64_t cycle = 0;
+        bool quitting = false;
+    };
+
+    struct Result {
+        int instances = 0, threads = 0;
+        double realtimeFactor = 0;    // seconds of audio of all instances per second
+        double load = 0;              // the average cycle, part of the time a block lasts
+        double worstCycleMs = 0, p99CycleMs = 0;
+        int overruns = 0;             // cycles that took longer than their block lasts
+        double worstInstanceUs = 0;   // the slowest single processBlock
+        size_t residentBytes = 0, bytesPerInstance = 0;
+        std::optional<CacheCounters::Reading> cache; // per cycle
+    };
+
+    static Result measure(std::vector<std::unique_ptr<Instance>>& instances, int amtInstances, int numThreads, const Options& options,
+                          SteadyPlayHead& playHead, const NoiseSource& noise, const CacheCounters& counters, juce::int64& time)
+    {
+        HostGraph graph{numThreads, [&](int i) { processInstance(*instances[static_cast<size_t>(i)], noise, time, options.sampleRate); }};
+
+        auto cycle = [&] {
+            playHead.setTime(time);
+            graph.runCycle(amtInstances);
+            time += options.blockSize;
+        };
+
+        // warms the caches and lets the workers settle
+        const auto blockSeconds = options.blockSize / options.sampleRate;
+        const int warmupCycles = std::max(8, static_cast<int>(0.25 / blockSeconds));
+        for (int i = 0; i < warmupCycles; i++) cycle();
+        for (int i = 0; i < amtInstances; i++) instances[static_cast<size_t>(i)]->worstMicroseconds = 0;
+
+        const int amtCycles = std::max(1, static_cast<int>(options.seconds / blockSeconds));
+        std::vector<double> cycleMs(static_cast<size_t>(amtCycles));
+
+        const auto countersBefore = counters.read();
+        const auto start = Clock::now();
+        for (auto& ms : cycleMs) {
+            const auto cycleStart = Clock::now();
+            cycle();
+            ms = std::chrono::duration<double, std::milli>(Clock::now() - cycleStart).count();
+        }
+        const auto seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        const auto countersAfter = counters.read();
+
+        Result result;
+        result.instances = amtInstances;
+        result.threads = numThreads;
+        result.realtimeFactor = amtCycles * blockSeconds * amtInstances / seconds;
+        result.load = seconds / amtCycles / blockSeconds;
+
+        std::sort(cycleMs.begin(), cycleMs.end());
+        result.worstCycleMs = cycleMs.back();
+        result.p99CycleMs = cycleMs[static_cast<size_t>((cycleMs.size() - 1) * 99 / 100)];
+        const auto deadlineMs = blockSeconds * 1000.0;
+        result.overruns = static_cast<int>(cycleMs.end() - std::upper_bound(cycleMs.begin(), cycleMs.end(), deadlineMs));
+
+        for (int i = 0; i < amtInstances; i++)
+            result.worstInstanceUs = std::max(result.worstInstanceUs, instances[static_cast<size_t>(i)]->worstMicroseconds);
+
+        if (countersBefore.has_value() && countersAfter.has_value()) {
+            const auto perCycle = [amtCycles](uint64_t before, uint64_t after) { return (after - before) / static_cast<uint64_t>(amtCycles); };
+            result.cache = CacheCounters::Reading{perCycle(countersBefore->references, countersAfter->references),
+                                                  perCycle(countersBefore->misses, countersAfter->misses),
+                                                  perCycle(countersBefore->instructions, countersAfter->instructions)};
+        }
+        return result;
+    }
+
+    static void printHeader(const Options& options, const char* kernel, bool hasCounters)
+    {
+        if (options.csv) {
+            std::printf("instances,threads,realtime,load,worst_cycle_ms,p99_cycle_ms,overruns,worst_instance_us,"
+                        "resident_mb,kb_per_instance,cache_refs_per_cycle,cache_misses_per_cycle,instructions_per_cycle\n");
+            return;
+        }
+        std::printf("%g Hz, %d samples per block (%.2f ms), %g s per run, %s kernels, cache counters %s\n\n",
+                    options.sampleRate, options.blockSize, options.blockSize / options.sampleRate * 1000.0, options.seconds,
+                    kernel, hasCounters ? "on" : "n/a");
+        std::printf("%9s %7s %10s %7s %10s %10s %8s %11s %9s %9s %12s %9s\n",
+                    "instances", "threads", "realtime", "load", "worst ms", "p99 ms", "overruns", "worst us",
+                    "rss MB", "KB/inst", "misses/cyc", "miss %");
+    }
+
+    static void printResult(const Result& r, const Options& options)
+    {
+        const auto residentMb = static_cast<double>(r.residentBytes) / (1024.0 * 1024.0);
+        const auto kbPerInstance = static_cast<double>(r.bytesPerInstance) / 1024.0;
+        if (options.csv) {
+            std::printf("%d,%d,%.2f,%.4f,%.4f,%.4f,%d,%.2f,%.2f,%.2f,", r.instances, r.threads, r.realtimeFactor, r.load,
+                        r.worstCycleMs, r.p99CycleMs, r.overruns, r.worstInstanceUs, residentMb, kbPerInstance);
+            if (r.cache.has_value())
+                std::printf("%llu,%llu,%llu\n", static_cast<unsigned long long>(r.cache->references),
+                            static_cast<unsigned long long>(r.cache->misses), static_cast<unsigned long long>(r.cache->instructions));
+            else
+                std::printf(",,\n");
+            return;
+        }
+
+        char missesPerCycle[32] = "n/a", missRate[32] = "n/a";
+        if (r.cache.has_value()) {
+            std::snprintf(missesPerCycle, sizeof(missesPerCycle), "%llu", static_cast<unsigned long long>(r.cache->misses));
+            if (r.cache->references > 0)
+                std::snprintf(missRate, sizeof(missRate), "%.2f", 100.0 * static_cast<double>(r.cache->misses) / static_cast<double>(r.cache->references));
+        }
+        std::printf("%9d %7d %9.1fx %6.1f%% %10.3f %10.3f %8d %11.1f %9.1f %9.1f %12s %9s\n",
+                    r.instances, r.threads, r.realtimeFactor, r.load * 100.0, r.worstCycleMs, r.p99CycleMs, r.overruns,
+                    r.worstInstanceUs, residentMb, kbPerInstance, missesPerCycle, missRate);
+    }
+
+    static std::optional<Options> parseOptions(const juce::ArgumentList& args)
+    {
+        Options options;
+        const auto hardwareThreads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+        for (int t = 1; t < hardwareThreads; t *= 2) options.threads.push_back(t);
+        options.threads.push_back(hardwareThreads);
+
+        if (args.containsOption("--help|-h")) return std::nullopt;
+        if (args.containsOption("--instances")) options.instances = parseList(args.getValueForOption("--instances"), 1, 512);
+        if (args.containsOption("--threads")) options.threads = parseList(args.getValueForOption("--threads"), 1, 256);
+        if (args.containsOption("--seconds")) options.seconds = args.getValueForOption("--seconds").getDoubleValue();
+        if (args.containsOption("--rate")) options.sampleRate = args.getValueForOption("--rate").getDoubleValue();
+        if (args.containsOption("--block")) options.blockSize = args.getValueForOption("--block").getIntValue();
+        if (args.containsOption("--kernel")) options.kernel = args.getValueForOption("--kernel");
+        options.csv = args.containsOption("--csv");
+
+        if (options.instances.empty() || options.threads.empty() || options.seconds <= 0.0
+            || options.sampleRate < 8000.0 || options.sampleRate > dsp::LookaheadDelay::maxSampleRate
+            || options.blockSize < 1 || options.blockSize > NoiseSource::length)
+            return std::nullopt;
+        return options;
+    }
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    using namespace duck::bench;
+
+    // before any thread starts, so every worker inherits the counters
+    const CacheCounters counters;
+    // the processors start timers and async updates, those need a message manager. its loop never runs here.
+    const juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    const auto options = parseOptions(juce::ArgumentList{argc, argv});
+    if (!options.has_value()) {
+        std::printf("usage: %s [--instances=1,2,...,512] [--threads=1,2,...] [--seconds=2] [--rate=48000] [--block=256]"
+                    " [--kernel=scalar|sse2|avx2|avx512|neon] [--csv]\n", argv[0]);
+        return 1;
+    }
+
+    SteadyPlayHead playHead{options->sampleRate};
+    const NoiseSource noise{2, options->blockSize};
+    std::vector<std::unique_ptr<Instance>> instances;
+    const auto residentAtStart = getResidentBytes();
+    juce::int64 time = 0;
+
+    bool printedHeader = false;
+    for (const auto amtInstances : options->instances) {
+        // the instances of the smaller counts keep going, only the new ones are made
+        while (static_cast<int>(instances.size()) < amtInstances)
+            instances.push_back(createInstance(static_cast<int>(instances.size()), *options, playHead));
+
+        if (!printedHeader) {
+            printHeader(*options, instances.front()->processor->getKernelName(), counters.isValid());
+            printedHeader = true;
+        }
+
+        for (const auto numThreads : options->threads) {
+            auto result = measure(instances, amtInstances, numThreads, *options, playHead, noise, counters, time);
+            // after running, so the pages that are only touched while processing count too
+            result.residentBytes = getResidentBytes();
+            result.bytesPerInstance = result.residentBytes > residentAtStart ? (result.residentBytes - residentAtStart) / static_cast<size_t>(amtInstances) : 0;
+            printResult(result, *options);
+            std::fflush(stdout);
+        }
+    }
+
+    for (auto& instance : instances)
+        instance->processor->releaseResources();
+    return 0;
+}
@@ -0,0 +1,91 @@
+/**
+ * @file DuckParameters.h
+ * @author Subnite
+ * @brief the host automatable parameters of the plugin.
+ *
+ */
+
+#pragma once
+#include <JuceHeader.h>
+#include <array>
+#include <memory>
+
+namespace duck::params
+{
+    /** Every parameter, in the order they're added to the processor and stored in the state. Only append to this. */
+    enum class ID {
+        LENGTH_MS, LOOKAHEAD_MS, DEPTH, MIX, COMBINE, TRIGGER, SWING,
+        STEM_2_DEPTH, STEM_3_DEPTH, STEM_4_DEPTH, STEM_5_DEPTH, STEM_6_DEPTH, STEM_7_DEPTH, STEM_8_DEPTH,
+        LINK, LINK_CHANNEL,
+        COUNT
+    };
+    constexpr size_t amount = static_cast<size_t>(ID::COUNT);
+
+    struct Info {
+        const char* id;
+        const char* name;
+        float minValue, maxValue, defaultValue;
+        float centreValue; // the value at the middle of the slider, skews the range when it's not the middle.
+        const char* label;
+        const char* choices = nullptr; // '|' separated, makes it a choice parameter with the index as value.
+    };
+
+    constexpr std::array<Info, amount> infos = {{
+        {"length",    "Length",    10.f, 2000.f, 300.f, 300.f, "ms"},  // LENGTH_MS
+        {"lookahead", "Lookahead",  0.f,   50.f,   0.f,  25.f, "ms"},  // LOOKAHEAD_MS
+        {"depth",     "Depth",      0.f,  100.f, 100.f,  50.f, "%"},   // DEPTH
+        {"mix",       "Mix",        0.f,  100.f, 100.f,  50.f, "%"},   // MIX
+        // latest by default, that's how a retrigger behaved before there was a choice, so older states sound the same.
+        {"combine",   "Combine",    0.f,    2.f,   0.f,   1.f, "", "Latest|Deepest|Multiply"}, // COMBINE, see duck::dsp::CombineMode
+        {"trigger",   "Trigger",    0.f,    2.f,   0.f,   1.f, "", "MIDI|Pattern|Both"},       // TRIGGER, see duck::dsp::TriggerSource
+        {"swing",     "Swing",      0.f,  100.f,   0.f,  50.f, "%"},   // SWING
+        // the depth of the stem buses, see duck::dsp::maxBuses. the main bus uses DEPTH.
+        {"depth2", "Stem 2 Depth",  0.f,  100.f, 100.f,  50.f, "%"},   // STEM_2_DEPTH
+        {"depth3", "Stem 3 Depth",  0.f,  100.f, 100.f,  50.f, "%"},   // STEM_3_DEPTH
+        {"depth4", "Stem 4 Depth",  0.f,  100.f, 100.f,  50.f, "%"},   // STEM_4_DEPTH
+        {"depth5", "Stem 5 Depth",  0.f,  100.f, 100.f,  50.f, "%"},   // STEM_5_DEPTH
+        {"depth6", "Stem 6 Depth",  0.f,  100.f, 100.f,  50.f, "%"},   // STEM_6_DEPTH
+        {"depth7", "Stem 7 Depth",  0.f,  100.f, 100.f,  50.f, "%"},   // STEM_7_DEPTH
+        {"depth8", "Stem 8 Depth",  0.f,  100.f, 100.f,  50.f, "%"},   // STEM_8_DEPTH
+        {"link",      "Link",         0.f,  2.f,  0.f, 1.f, "", "Off|Send|Receive"}, // LINK, see duck::dsp::LinkMode
+        {"linkChannel", "Link Channel", 0.f, 15.f, 0.f, 7.f, "", "1|2|3|4|5|6|7|8|9|10|11|12|13|14|15|16"}, // LINK_CHANNEL
+    }};
+
+    constexpr const Info& get(ID id) { return infos[static_cast<size_t>(id)]; }
+
+    /** The amount of trigger link channels, see LINK_CHANNEL. */
+    constexpr int amtLinkChannels = 16;
+
+    /** @return The depth parameter of stem bus, 1 is the first bus after the main one. */
+    constexpr ID getStemDepth(int bus) { return static_cast<ID>(static_cast<int>(ID::STEM_2_DEPTH) + bus - 1); }
+
+    /** The plain (not normalized) value of every parameter, indexed by ID. */
+    using Values = std::array<float, amount>;
+
+    inline Values getDefaults()
+    {
+        Values values{};
+        for (size_t i = 0; i < amount; i++)
+            values[i] = infos[i].defaultValue;
+        return values;
+    }
+
+    /** Makes the parameter for id, hand it to juce::AudioProcessor::addParameter. */
+    inline std::unique_ptr<juce::RangedAudioParameter> create(ID id)
+    {
+        const auto& info = get(id);
+        if (info.choices != nullptr) {
+            return std::make_unique<juce::AudioParameterChoice>(
+                juce::ParameterID{info.id, 1}, info.name, juce::StringArray::fromTokens(info.choices, "|", {}),
+                static_cast<int>(info.defaultValue));
+        }
+
+        juce::NormalisableRange<float> range{info.minValue, info.maxValue};
+        range.setSkewForCentre(info.centreValue);
+
+        return std::make_unique<juce::AudioParameterFloat>(
+            juce::ParameterID{info.id, 1}, info.name, range, info.defaultValue,
+            juce::AudioParameterFloatAttributes().withLabel(info.label));
+    }
+
+} // namespace
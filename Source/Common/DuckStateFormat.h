@@ -0,0 +1,212 @@
+/**
+ * @file DuckStateFormat.h
+ * @author Subnite
+ * @brief the compact binary layout used to store and restore the plugin state.
+ *
+ */
+
+#pragma once
+#include <JuceHeader.h>
+#include <algorithm>
+#include <cstring>
+#include <optional>
+#include "DuckValueTree.h"
+#include "DuckParameters.h"
+
+namespace duck::vt::state
+{
+    /**
+     * Layout, all values little endian:
+     *
+     * header       u32 magic "HDuk", u16 version, u16 flags (unused, 0), u32 amount of points
+     * parameters   version 1: for the length and then the lookahead slider,
+     *                         f64 displayValue, f64 minValue, f64 maxValue, f64 rawNormalizedValue
+     *              version 2: u32 amount of parameters, then per parameter in duck::params::ID order: f32 value
+     * points       per point: f32 x, f32 y, f32 power, f32 maxAbsPower, f32 size
+     * pattern      version 3: u32 steps of the trigger pattern, bit n is step n
+     *
+     * Parameters missing from a blob keep their default, ones this version doesn't know are skipped.
+     * Blobs that don't start with the magic are legacy juce::ValueTree blobs, those start with the root type name.
+     */
+    constexpr uint32 magic = 0x6b754448; // "HDuk" when read as little endian bytes
+    constexpr uint16 version = 3;
+
+    constexpr size_t headerSize = 4 + 2 + 2 + 4;
+    constexpr size_t sliderSize = 4 * sizeof(double);
+    constexpr size_t amtSliders = 2; // version 1 only, length and lookahead
+    constexpr size_t pointSize = 5 * sizeof(float);
+
+    struct PointValues {
+        float x{}, y{}, power{}, maxAbsPower{}, size{};
+    };
+
+    /** Reads a binary state in place, without copying the data. Only valid as long as the data is. */
+    class View
+    {
+    public:
+        /** @return The view on data, or std::nullopt if data isn't a (complete) binary state. */
+        static std::optional<View> parse(const void* data, size_t sizeInBytes)
+        {
+            if (data == nullptr || sizeInBytes < headerSize) return std::nullopt;
+
+            auto bytes = static_cast<const char*>(data);
+            if (readLE<uint32>(bytes) != magic) return std::nullopt;
+
+            View view;
+            view.formatVersion = readLE<uint16>(bytes + 4);
+            view.amtPoints = readLE<uint32>(bytes + 8);
+            if (view.formatVersion < 1 || view.formatVersion > version) return std::nullopt;
+
+            size_t parametersSize = amtSliders * sliderSize;
+            if (view.formatVersion >= 2) {
+                if (sizeInBytes < headerSize + 4) return std::nullopt;
+                view.amtParameters = readLE<uint32>(bytes + headerSize);
+                parametersSize = 4 + static_cast<size_t>(view.amtParameters) * sizeof(float);
+            }
+
+            view.parameterData = bytes + headerSize;
+            view.pointData = view.parameterData + parametersSize;
+            const size_t pointsSize = static_cast<size_t>(view.amtPoints) * pointSize;
+            const size_t patternSize = view.formatVersion >= 3 ? 4 : 0;
+            if (sizeInBytes < headerSize + parametersSize + pointsSize + patternSize) return std::nullopt;
+            view.patternData = view.formatVersion >= 3 ? view.pointData + pointsSize : nullptr;
+
+            return view;
+        }
+
+        uint16 getVersion() const { return formatVersion; }
+        size_t getNumPoints() const { return amtPoints; }
+        size_t getNumParameters() const { return amtParameters; } // 0 for version 1, it stored sliders
+
+        /** @return The stored parameter values, defaults for the ones that weren't stored. */
+        params::Values getParameters() const
+        {
+            auto values = params::getDefaults();
+            if (formatVersion == 1) {
+                // the display value of the length and lookahead sliders
+                values[static_cast<size_t>(params::ID::LENGTH_MS)] = static_cast<float>(readLE<double>(parameterData));
+                values[static_cast<size_t>(params::ID::LOOKAHEAD_MS)] = static_cast<float>(readLE<double>(parameterData + sliderSize));
+                return values;
+            }
+
+            const auto stored = std::min<size_t>(amtParameters, params::amount);
+            for (size_t i = 0; i < stored; i++)
+                values[i] = readLE<float>(parameterData + 4 + i * sizeof(float));
+            return values;
+        }
+
+        /** @return The steps of the trigger pattern, the default ones before version 3. */
+        uint32 getPatternSteps() const
+        {
+            return patternData != nullptr ? readLE<uint32>(patternData) : duck::dsp::pattern::defaultSteps;
+        }
+
+        PointValues getPoint(size_t pointIndex) const
+        {
+            jassert(pointIndex < amtPoints);
+            auto p = pointData + pointIndex * pointSize;
+            return {readLE<float>(p), readLE<float>(p + 4), readLE<float>(p + 8), readLE<float>(p + 12), readLE<float>(p + 16)};
+        }
+
+    private:
+        template <typename T>
+        static T readLE(const char* p)
+        {
+            // memcpy, the blob has no alignment guarantees
+            if constexpr (sizeof(T) == 2) {
+                uint16 v; std::memcpy(&v, p, 2); v = juce::ByteOrder::swapIfBigEndian(v);
+                T out; std::memcpy(&out, &v, 2); return out;
+            } else if constexpr (sizeof(T) == 4) {
+                uint32 v; std::memcpy(&v, p, 4); v = juce::ByteOrder::swapIfBigEndian(v);
+                T out; std::memcpy(&out, &v, 4); return out;
+            } else {
+                uint64 v; std::memcpy(&v, p, 8); v = juce::ByteOrder::swapIfBigEndian(v);
+                T out; std::memcpy(&out, &v, 8); return out;
+            }
+        }
+
+        uint16 formatVersion = 0;
+        uint32 amtPoints = 0;
+        uint32 amtParameters = 0;
+        const char* parameterData = nullptr;
+        const char* pointData = nullptr;
+        const char* patternData = nullptr;
+    };
+
+    /** Writes the tree and parameters to destData in the binary layout, replacing what was in there. */
+    inline void write(const duck::vt::ValueTree& tree, const params::Values& parameters, juce::MemoryBlock& destData)
+    {
+        const auto& root = tree.getRoot();
+        const auto points = root.getChildWithName(tree.getIDFromType(Property::T_CURVE_DATA))
+                                .getChildWithName(tree.getIDFromType(Property::T_NORMALIZED_POINTS));
+        const auto amtPoints = static_cast<uint32>(points.getNumChildren());
+
+        destData.setSize(0);
+        destData.ensureSize(headerSize + 4 + params::amount * sizeof(float) + amtPoints * pointSize + 4);
+        juce::MemoryOutputStream stream{destData, false};
+
+        stream.writeInt(static_cast<int>(magic));
+        stream.writeShort(static_cast<short>(version));
+        stream.writeShort(0);
+        stream.writeInt(static_cast<int>(amtPoints));
+
+        stream.writeInt(static_cast<int>(params::amount));
+        for (const auto value : parameters)
+            stream.writeFloat(value);
+
+        auto id = [&tree](Property p) -> const juce::Identifier& { return tree.getIDFromType(p); };
+        for (int i = 0; i < points.getNumChildren(); i++) {
+            const auto point = points.getChild(i);
+            stream.writeFloat(point.getProperty(id(Property::P_X)));
+            stream.writeFloat(point.getProperty(id(Property::P_Y)));
+            stream.writeFloat(point.getProperty(id(Property::P_POWER)));
+            stream.writeFloat(point.getProperty(id(Property::P_MAX_ABSOLUTE_POWER)));
+            stream.writeFloat(point.getProperty(id(Property::P_SIZE)));
+        }
+
+        stream.writeInt(static_cast<int>(tree.getPatternSteps()));
+    }
+
+    /**
+     * Overwrites the parameter values of a state written by this version in place, the tree part stays as it is.
+     * @return false if the blob isn't one, it's left untouched then.
+     */
+    inline bool writeParameters(const params::Values& parameters, juce::MemoryBlock& destData)
+    {
+        const auto view = View::parse(destData.getData(), destData.getSize());
+        if (!view.has_value() || view->getVersion() != version || view->getNumParameters() != params::amount) return false;
+
+        auto bytes = static_cast<char*>(destData.getData()) + headerSize + 4;
+        for (const auto value : parameters) {
+            uint32 v; std::memcpy(&v, &value, 4);
+            v = juce::ByteOrder::swapIfBigEndian(v);
+            std::memcpy(bytes, &v, 4);
+            bytes += 4;
+        }
+        return true;
+    }
+
+    /**
+     * Replaces the tree with the state in data.
+     * @return The stored parameter values, or std::nullopt if data isn't a binary state. The tree is untouched then so a legacy blob can be tried.
+     */
+    inline std::optional<params::Values> read(const void* data, size_t sizeInBytes, duck::vt::ValueTree& tree)
+    {
+        const auto view = View::parse(data, sizeInBytes);
+        if (!view.has_value()) return std::nullopt;
+
+        tree.create();
+        tree.clearPoints();
+
+        for (size_t i = 0; i < view->getNumPoints(); i++) {
+            const auto p = view->getPoint(i);
+            tree.addPoint({p.x, p.y}, p.power, p.maxAbsPower, p.size);
+        }
+        tree.setPatternSteps(view->getPatternSteps());
+
+        // loading a state isn't something to undo
+        tree.getUndoManager()->clearUndoHistory();
+        return view->getParameters();
+    }
+
+} // namespace
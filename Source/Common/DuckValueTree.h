@@ -1,20 +1,56 @@
 #pragma once
 #include <JuceHeader.h>
 #include "ValueTreeManager.h"
+#include "PatternClock.h"
 
 enum class Property {
     // trees
     T_ROOT, T_CURVE_DATA, T_NORMALIZED_POINTS, T_POINT,
-    T_LENGTH_MS,
-    T_LOOKAHEAD_MS,
+    T_LENGTH_MS,    // legacy, only read from old states
+    T_LOOKAHEAD_MS, // legacy, only read from old states
     
     // properties
     P_POWER, P_MAX_ABSOLUTE_POWER, P_SIZE, P_X, P_Y,
     P_RAW_NORMALIZED_VALUE, P_DISPLAY_VALUE, P_MIN_VALUE, P_MAX_VALUE,
+    P_PATTERN_STEPS,
     
     COUNT
 };
 
+namespace subnite::vt {
+
+template <>
+struct IDNames<Property> {
+    static constexpr std::array<const char*, static_cast<size_t>(Property::COUNT)> names = {
+        // trees
+        "HentaiDuckRoot",       // T_ROOT
+        // curve display trees
+        "CurveData",            // T_CURVE_DATA
+        "NormalizedPoints",     // T_NORMALIZED_POINTS
+        "Point",                // T_POINT
+        // length slider trees
+        "LengthMS",             // T_LENGTH_MS
+        // lookahead slider trees
+        "LookaheadMS",          // T_LOOKAHEAD_MS
+
+        // curve display properties
+        "power",                // P_POWER
+        "maxAbsolutePower",     // P_MAX_ABSOLUTE_POWER
+        "size",                 // P_SIZE
+        "x",                    // P_X
+        "y",                    // P_Y
+        // slider properties
+        "rawNormalizedValue",   // P_RAW_NORMALIZED_VALUE
+        "displayValue",         // P_DISPLAY_VALUE
+        "minValue",             // P_MIN_VALUE
+        "maxValue",             // P_MAX_VALUE
+        // pattern properties
+        "patternSteps",         // P_PATTERN_STEPS
+    };
+};
+
+} // namespace
+
 namespace duck::vt {
 
 class ValueTree : public subnite::vt::ValueTreeBase, public subnite::vt::IDMap<Property> {
@@ -22,56 +58,17 @@ public:
     ValueTree()
     : subnite::vt::ValueTreeBase(), subnite::vt::IDMap<Property>()
     {
-        setupMap();
     };
     ~ValueTree(){};
 
-    void setupMap() override {
-        using p = Property;
-        using id = juce::Identifier;
-
-        #pragma region trees
-        map[p::T_ROOT] = id{"HentaiDuckRoot"};
-
-        // curve display trees
-        map[p::T_CURVE_DATA] = id{"CurveData"};
-        map[p::T_NORMALIZED_POINTS] = id{"NormalizedPoints"};
-        map[p::T_POINT] = id{"Point"};
-
-        // length slider trees
-        map[p::T_LENGTH_MS] = id{"LengthMS"};
-
-        // lookahead slider trees
-        map[p::T_LOOKAHEAD_MS] = id{"LookaheadMS"};
-
-        #pragma endregion trees
-
-        #pragma region properties
-        // curve display properties
-        map[p::P_POWER] = id{"power"};
-        map[p::P_MAX_ABSOLUTE_POWER] = id{"maxAbsolutePower"};
-        map[p::P_SIZE] = id{"size"};
-        map[p::P_X] = id{"x"};
-        map[p::P_Y] = id{"y"};
-
-        // slider properties
-        map[p::P_RAW_NORMALIZED_VALUE] = id{"rawNormalizedValue"};
-        map[p::P_DISPLAY_VALUE] = id{"displayValue"};
-        map[p::P_MIN_VALUE] = id{"minValue"};
-        map[p::P_MAX_VALUE] = id{"maxValue"};
-
-        #pragma endregion properties
-    }
-
     // makes the default tree
     void create() override {
         using prop = Property;
-        using id = juce::Identifier;
 
         // create new one
-        vtRoot = juce::ValueTree{getIDFromType(prop::T_ROOT).value_or(id{"undefined"})};
-        juce::ValueTree curve{getIDFromType(prop::T_CURVE_DATA).value_or(id{"undefined"})};
-        juce::ValueTree points{getIDFromType(prop::T_NORMALIZED_POINTS).value_or(id{"undefined"})};
+        vtRoot = juce::ValueTree{getIDFromType(prop::T_ROOT)};
+        juce::ValueTree curve{getIDFromType(prop::T_CURVE_DATA)};
+        juce::ValueTree points{getIDFromType(prop::T_NORMALIZED_POINTS)};
         curve.appendChild(points, &undoManager);
         vtRoot.appendChild(curve, &undoManager);
 
@@ -80,40 +77,46 @@ public:
         addPoint({0.3f, 0.3f}, -8.f, 50.f, 20.f);
         addPoint({0.5f, 0.f}, 0.f, 50.f, 20.f);
         addPoint({1.f, 0.f}, 0.f, 50.f, 20.f);
+        setPatternSteps(duck::dsp::pattern::defaultSteps);
+
+        // length and lookahead are host parameters now (see DuckParameters.h), older states still have their slider trees.
 
-        // right now the length slider tree is created by the slider class, changing this would also work, but then add all possible values.
-        juce::ValueTree lengthSliderTree{getIDFromType(prop::T_LENGTH_MS).value_or(id{"undefined"})};
-        lengthSliderTree.setProperty(getIDFromType(prop::P_DISPLAY_VALUE).value_or(id{"undefined"}), 300.0, nullptr);
-        lengthSliderTree.setProperty(getIDFromType(prop::P_MIN_VALUE).value_or(id{"undefined"}), 10.0, nullptr);
-        lengthSliderTree.setProperty(getIDFromType(prop::P_MAX_VALUE).value_or(id{"undefined"}), 2000.0, nullptr);
-        lengthSliderTree.setProperty(getIDFromType(prop::P_RAW_NORMALIZED_VALUE).value_or(id{"undefined"}), 0.20, nullptr);
+        // the default tree isn't something to undo
+        undoManager.clearUndoHistory();
+    }
 
-        vtRoot.appendChild(lengthSliderTree, &undoManager);
+    // removes all points from the curve.
+    void clearPoints() {
+        using prop = Property;
 
+        auto curve = vtRoot.getChildWithName(getIDFromType(prop::T_CURVE_DATA));
+        auto points = curve.getChildWithName(getIDFromType(prop::T_NORMALIZED_POINTS));
+        points.removeAllChildren(&undoManager);
+    }
 
-        juce::ValueTree lookaheadSliderTree{getIDFromType(prop::T_LOOKAHEAD_MS).value_or(id{"undefined"})};
-        lookaheadSliderTree.setProperty(getIDFromType(prop::P_DISPLAY_VALUE).value_or(id{"undefined"}), 0.0, nullptr);
-        lookaheadSliderTree.setProperty(getIDFromType(prop::P_MIN_VALUE).value_or(id{"undefined"}), 0.0, nullptr);
-        lookaheadSliderTree.setProperty(getIDFromType(prop::P_MAX_VALUE).value_or(id{"undefined"}), 50.0, nullptr);
-        lookaheadSliderTree.setProperty(getIDFromType(prop::P_RAW_NORMALIZED_VALUE).value_or(id{"undefined"}), 0.0, nullptr);
+    // the steps of the trigger pattern, bit n is step n. see duck::dsp::pattern.
+    uint32_t getPatternSteps() const {
+        const auto steps = vtRoot.getProperty(getIDFromType(Property::P_PATTERN_STEPS), static_cast<int>(duck::dsp::pattern::defaultSteps));
+        return static_cast<uint32_t>(static_cast<int>(steps)) & ((1u << duck::dsp::pattern::amtSteps) - 1);
+    }
 
-        vtRoot.appendChild(lookaheadSliderTree, &undoManager);
+    void setPatternSteps(uint32_t steps) {
+        vtRoot.setProperty(getIDFromType(Property::P_PATTERN_STEPS), static_cast<int>(steps), &undoManager);
     }
 
     void addPoint(const juce::Point<float>& coords, const float& power, const float& maxAbsPower, const float& size) {
         using prop = Property;
-        using id = juce::Identifier;
 
-        auto curve = vtRoot.getOrCreateChildWithName(getIDFromType(prop::T_CURVE_DATA).value_or(id{"undefined"}), &undoManager);
-        auto points = curve.getOrCreateChildWithName(getIDFromType(prop::T_NORMALIZED_POINTS).value_or(id{"undefined"}), &undoManager);
+        auto curve = vtRoot.getOrCreateChildWithName(getIDFromType(prop::T_CURVE_DATA), &undoManager);
+        auto points = curve.getOrCreateChildWithName(getIDFromType(prop::T_NORMALIZED_POINTS), &undoManager);
         if (!points.isValid()) return;
-        juce::ValueTree point{getIDFromType(prop::T_POINT).value_or(id{"undefined"})};
+        juce::ValueTree point{getIDFromType(prop::T_POINT)};
 
-        point.setProperty(getIDFromType(prop::P_X).value_or(id{"undefined"}), {double(coords.x)}, &undoManager);
-        point.setProperty(getIDFromType(prop::P_Y).value_or(id{"undefined"}), {double(coords.y)}, &undoManager);
-        point.setProperty(getIDFromType(prop::P_POWER).value_or(id{"undefined"}), {double(power)}, &undoManager);
-        point.setProperty(getIDFromType(prop::P_MAX_ABSOLUTE_POWER).value_or(id{"undefined"}), {double(maxAbsPower)}, &undoManager);
-        point.setProperty(getIDFromType(prop::P_SIZE).value_or(id{"undefined"}), {double(size)}, &undoManager);
+        point.setProperty(getIDFromType(prop::P_X), {double(coords.x)}, &undoManager);
+        point.setProperty(getIDFromType(prop::P_Y), {double(coords.y)}, &undoManager);
+        point.setProperty(getIDFromType(prop::P_POWER), {double(power)}, &undoManager);
+        point.setProperty(getIDFromType(prop::P_MAX_ABSOLUTE_POWER), {double(maxAbsPower)}, &undoManager);
+        point.setProperty(getIDFromType(prop::P_SIZE), {double(size)}, &undoManager);
 
         points.appendChild(point, &undoManager);
     };
@@ -7,42 +7,112 @@
 
 #pragma once
 #include <JuceHeader.h>
+#include <array>
+#include <cstdint>
 #include <optional>
-#include <unordered_map>
 
 namespace subnite::vt
 {
 
+    /**
+     * The identifier names of every value in E_ID, specialize this for your enum.
+     *
+     * E_ID has to end with a COUNT value, and names needs exactly one unique, non empty name per value, in enum order.
+     * This is checked at compile time by IDMap.
+     *
+     * example code:
+     * @code
+     * enum class MyIDs { ROOT, DELAY_SLIDER, COUNT };
+     *
+     * namespace subnite::vt {
+     * template <>
+     * struct IDNames<MyIDs> {
+     *     static constexpr std::array<const char*, static_cast<size_t>(MyIDs::COUNT)> names = {
+     *         "RootName",     // ROOT
+     *         "DelaySlider",  // DELAY_SLIDER
+     *     };
+     * };
+     * }
+     * @endcode
+     */
+    template <typename E_ID>
+    struct IDNames;
+
     template <typename E_ID>
     class IDMap
     {
-    protected:
-        /**
-         * The map used for connecting an enum to id's
-         */
-        std::unordered_map<E_ID, juce::Identifier> map;
+    public:
+        /** The amount of mapped values, E_ID::COUNT. */
+        static constexpr size_t size = static_cast<size_t>(E_ID::COUNT);
 
-        /**
-         * @brief creates the mappings from E_ID to juce::Identifier
-         *
-         * you can access the this->map variable, and are supposed to fill it with all possible enums.
-         * 
-         * example code:
-         * @code
-         * void setupMap() override {
-         *     this->map[E_ID::ROOT] = juce::Identifier{"RootName"};
-         *     this->map[E_ID::DELAY_SLIDER] = juce::Identifier{"DelaySlider"};
-         * }
-         * @endcode
-         */
-        virtual void setupMap() = 0;
+    private:
+        static constexpr auto& names = IDNames<E_ID>::names;
+        static_assert(names.size() == size, "IDNames needs exactly one name per enum value");
+
+        static constexpr bool namesAreValid()
+        {
+            for (size_t i = 0; i < size; i++)
+            {
+                if (names[i] == nullptr || names[i][0] == '\0')
+                    return false;
+
+                for (size_t j = i + 1; j < size; j++)
+                {
+                    size_t c = 0;
+                    while (names[i][c] != '\0' && names[i][c] == names[j][c])
+                        c++;
+                    if (names[i][c] == names[j][c])
+                        return false; // same name twice
+                }
+            }
+            return true;
+        }
+        static_assert(namesAreValid(), "IDNames has an empty or duplicate name");
+
+        // power of two, at least twice the amount of names, for the reverse lookup table.
+        static constexpr size_t lookupSize = []
+        {
+            size_t s = 1;
+            while (s < size * 2)
+                s *= 2;
+            return s;
+        }();
+
+        struct Tables
+        {
+            std::array<juce::Identifier, size> ids;
+            std::array<int, lookupSize> lookup; // open addressing on the pooled string address, -1 is empty
+        };
+
+        static size_t hashOf(const juce::Identifier &id)
+        {
+            auto address = reinterpret_cast<std::uintptr_t>(id.getCharPointer().getAddress());
+            return static_cast<size_t>((address >> 3) * 0x9E3779B97F4A7C15ull) & (lookupSize - 1);
+        }
+
+        /** Interns every identifier once per process, identifiers are pooled strings so equal ids share an address. */
+        static const Tables &getTables()
+        {
+            static const Tables tables = []
+            {
+                Tables t;
+                t.lookup.fill(-1);
+                for (size_t i = 0; i < size; i++)
+                {
+                    t.ids[i] = juce::Identifier{names[i]};
+                    auto slot = hashOf(t.ids[i]);
+                    while (t.lookup[slot] != -1)
+                        slot = (slot + 1) & (lookupSize - 1);
+                    t.lookup[slot] = static_cast<int>(i);
+                }
+                return t;
+            }();
+            return tables;
+        }
 
     public:
         /**
-         * Default IDMap constructor, doesn't do any setup.
-         *
-         * CALL setupMap() MANUALLY ON CONSTRUCTOR!!
-         * The juce vst3 helper crashes when this abstract class tries to call setupMap(), so do it yourself!
+         * Default IDMap constructor, nothing to set up, the mapping is made at compile time from IDNames<E_ID>.
          */
         IDMap()
         {
@@ -53,34 +123,30 @@ namespace subnite::vt
          * @param id The identifier linked with an enum.
          * @return The E_ID::enum linked with id, or std::nullopt if it wasn't found.
          */
-        std::optional<E_ID> getTypeFromID(const juce::Identifier &id) const
+        static std::optional<E_ID> getTypeFromID(const juce::Identifier &id)
         {
-            auto it = std::find_if(map.begin(), map.end(), [&id](const std::pair<E_ID, juce::Identifier> &pair)
-                                   {
-                                       return pair.second == id; // Find the pair where value matches
-                                   });
-
-            if (it != map.end())
+            const auto &tables = getTables();
+            for (auto slot = hashOf(id);; slot = (slot + 1) & (lookupSize - 1))
             {
-                return it->first; // Return key if value is found
+                const auto index = tables.lookup[slot];
+                if (index == -1)
+                    return std::nullopt;
+                if (tables.ids[static_cast<size_t>(index)] == id)
+                    return static_cast<E_ID>(index);
             }
-            return std::nullopt; // Return an empty optional if value is not found
         }
 
         /**
          * get the ID associated with mapped Enum
          *
-         * @param property The enum that associates to a juce::Identifier.
-         * @return The ID linked with the enum, or std::nullopt if not found.
+         * @param property The enum that associates to a juce::Identifier, anything but COUNT.
+         * @return The interned ID linked with the enum.
          */
-        std::optional<juce::Identifier> getIDFromType(const E_ID &property) const
+        static const juce::Identifier &getIDFromType(const E_ID &property)
         {
-            auto it = map.find(property);
-            if (it != map.end())
-            {
-                return it->second; // Return value if key is found
-            }
-            return std::nullopt;
+            const auto index = static_cast<size_t>(property);
+            jassert(index < size);
+            return getTables().ids[std::min(index, size - 1)];
         }
     };
 
@@ -125,12 +191,18 @@ namespace subnite::vt
         return vtRoot.isValid();
     }
 
-    /** Adds a listener to the root tree. */
+    /** Adds a listener to the root tree. It keeps listening when the root is replaced, see juce::ValueTree::Listener::valueTreeRedirected. */
     void addListener(juce::ValueTree::Listener *listener)
     {
         vtRoot.addListener(listener);
     }
 
+    /** Removes a listener from the root tree. */
+    void removeListener(juce::ValueTree::Listener *listener)
+    {
+        vtRoot.removeListener(listener);
+    }
+
     /** @return The undo manager used for all things. Could be nullptr */
     juce::UndoManager *getUndoManager()
     {
@@ -141,6 +213,7 @@ namespace subnite::vt
     bool copyFrom(const void *data, int sizeInBytes)
     {
         vtRoot = juce::ValueTree::readFromData(data, sizeInBytes);
+        undoManager.clearUndoHistory(); // the history refers to the old tree
         return vtRoot.isValid();
     }
 
@@ -220,26 +293,17 @@ namespace subnite::vt
 
     /** Removes the first child matching the type, and replaces it with tree if possible. Otherwise it makes a new child.
      *
-     * This happens recursively through all children (not optimized) !!! Currently only looks at the direct children of the tree !!!
+     * The existing child isn't actually replaced, toTree is diffed into it so only the properties and children
+     * that differ end up in the undo history. !!! Currently only looks at the direct children of the tree !!!
      *
      */
     void setChild(const juce::Identifier &id, juce::ValueTree &toTree)
     {
         auto oldTree = vtRoot.getChildWithName(id);
-        // auto oldTree = getChildRecursive(id, vtRoot);
 
-        if (/*oldTree != nullptr &&*/ oldTree.isValid())
+        if (oldTree.isValid())
         {
-            auto parent = oldTree.getParent();
-            if (parent.isValid())
-            {
-                auto idx = parent.indexOf(oldTree);
-                if (idx >= 0)
-                {
-                    parent.removeChild(idx, &undoManager);
-                }
-                parent.appendChild(toTree, &undoManager);
-            }
+            syncTree(oldTree, toTree);
         }
         else
     {
@@ -248,11 +312,67 @@ namespace subnite::vt
         }
     }
 
+    /**
+     * Starts a new undo transaction, call this at the start of every user gesture (like mouseDown).
+     * Everything changed until the next call is undone in one step, and repeated changes to the same property are coalesced.
+     */
+    void beginTransaction()
+    {
+        undoManager.beginNewTransaction();
+    }
+
+    /** Sets how much undo history is kept, older transactions are dropped first. @see juce::UndoManager::setMaxNumberOfStoredUnits */
+    void setUndoLimits(int maxUnits, int minTransactions)
+    {
+        undoManager.setMaxNumberOfStoredUnits(maxUnits, minTransactions);
+    }
+
+    /** Roughly the bytes of undo history kept by default, ValueTree actions report their size in bytes. */
+    static constexpr int defaultMaxUndoUnits = 256 * 1024;
+    /** The amount of transactions kept even if they go over defaultMaxUndoUnits. */
+    static constexpr int defaultMinUndoTransactions = 8;
+
 protected:
+    /** Makes target equal to source with the fewest undoable actions. Children are matched by index and type. */
+    void syncTree(juce::ValueTree &target, const juce::ValueTree &source)
+    {
+        for (int i = target.getNumProperties(); --i >= 0;)
+        {
+            const auto name = target.getPropertyName(i);
+            if (!source.hasProperty(name))
+                target.removeProperty(name, &undoManager);
+        }
+
+        // setProperty doesn't record anything when the value didn't change
+        for (int i = 0; i < source.getNumProperties(); i++)
+        {
+            const auto name = source.getPropertyName(i);
+            target.setProperty(name, source.getProperty(name), &undoManager);
+        }
+
+        for (int i = 0; i < source.getNumChildren(); i++)
+        {
+            const auto sourceChild = source.getChild(i);
+            if (i < target.getNumChildren() && target.getChild(i).hasType(sourceChild.getType()))
+            {
+                auto targetChild = target.getChild(i);
+                syncTree(targetChild, sourceChild);
+                continue;
+            }
+
+            if (i < target.getNumChildren())
+                target.removeChild(i, &undoManager);
+            target.addChild(sourceChild.createCopy(), i, &undoManager);
+        }
+
+        while (target.getNumChildren() > source.getNumChildren())
+            target.removeChild(target.getNumChildren() - 1, &undoManager);
+    }
+
     /** The root value tree. */
     juce::ValueTree vtRoot;
     /** The undomanager associated with the vtRoot root tree. */
-    juce::UndoManager undoManager{};
+    juce::UndoManager undoManager{defaultMaxUndoUnits, defaultMinUndoTransactions};
 };
 
 } // namespace
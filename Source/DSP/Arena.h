@@ -0,0 +1,63 @@
+#pragma once
+#include <JuceHeader.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <new>
+
+namespace duck::dsp {
+
+/**
+ * One cache line aligned block of memory for all per instance DSP state, so it sits together instead of all over the heap.
+ *
+ * Lay everything out with reserve() first, then allocate() once and get() the pieces. Every reserved range
+ * starts on its own cache line. clear() starts a new layout but keeps the memory, allocate() only reallocates
+ * when the new layout doesn't fit.
+*/
+class Arena {
+public:
+    static constexpr size_t alignment = 64;
+
+    /** Reserves room for count Ts. @return The offset to get them at after allocate(). */
+    template <typename T>
+    size_t reserve(size_t count) {
+        static_assert(alignof(T) <= alignment, "the arena only aligns to cache lines");
+        const size_t offset = layoutSize;
+        layoutSize += roundUp(count * sizeof(T));
+        return offset;
+    }
+
+    /** Makes room for the layout and zeroes it. */
+    void allocate() {
+        if (layoutSize > capacity || memory == nullptr) {
+            memory.reset(static_cast<std::byte*>(::operator new(std::max(layoutSize, alignment), std::align_val_t{alignment})));
+            capacity = std::max(layoutSize, alignment);
+        }
+        std::memset(memory.get(), 0, layoutSize);
+    }
+
+    /** Starts a new layout, the memory is kept for the next allocate(). */
+    void clear() { layoutSize = 0; }
+
+    template <typename T>
+    T* get(size_t offset) const {
+        jassert(memory != nullptr && offset <= layoutSize);
+        return reinterpret_cast<T*>(memory.get() + offset);
+    }
+
+    /** @return The bytes used by the current layout. */
+    size_t getSize() const { return layoutSize; }
+
+private:
+    struct AlignedDelete {
+        void operator()(std::byte* p) const { ::operator delete(p, std::align_val_t{alignment}); }
+    };
+    static size_t roundUp(size_t bytes) { return (bytes + alignment - 1) & ~(alignment - 1); }
+
+    std::unique_ptr<std::byte, AlignedDelete> memory;
+    size_t layoutSize = 0;
+    size_t capacity = 0;
+};
+
+} // namespace
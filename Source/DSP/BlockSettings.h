@@ -0,0 +1,55 @@
+#pragma once
+#include <array>
+#include <cstdint>
+
+namespace duck::dsp {
+
+namespace simd { struct KernelSet; }
+
+/** The main bus and the stem bus pairs, every one ducked by the same curve with its own depth. */
+constexpr int maxBuses = 8;
+
+/** How the curves of overlapping note ons make one gain, the index of the combine parameter. Only append to this. */
+enum class CombineMode : int {
+    LATEST,   // a note on stops the curves before it
+    DEEPEST,  // the lowest gain of every playing curve
+    MULTIPLY, // the gains of every playing curve multiplied
+};
+
+/** Where the note ons come from, the index of the trigger parameter. Only append to this. */
+enum class TriggerSource : int {
+    MIDI,
+    PATTERN, // the steps of the pattern on the host's beat grid
+    BOTH,
+};
+
+/** What the instance does with the trigger link, the index of the link parameter. Only append to this. */
+enum class LinkMode : int {
+    OFF,
+    SEND,    // publishes its triggers to the link channel
+    RECEIVE, // adds the triggers of the link channel to its own
+};
+
+/** The curve the message thread published, see TripleBuffer. */
+struct CurveSettings {
+    const float* table = nullptr; // CurveTableStore::resolution + 1 values, kept alive by the processor until the audio thread moved past generation
+    uint64_t generation = 0;
+};
+
+/** Everything a block is processed with, read once at the start of processBlock. The audio thread reads nothing else. */
+struct BlockSettings {
+    const float* curveTable = nullptr;
+    const simd::KernelSet* kernels = nullptr; // the instruction set the hot loops run with
+    float lengthMs = 300.f;
+    float lookaheadMs = 0.f;
+    float depth = 100.f; // percent, of the main bus
+    std::array<float, maxBuses - 1> stemDepths{}; // percent, of the stem buses after the main one
+    float mix = 100.f;   // percent
+    CombineMode combine = CombineMode::LATEST;
+    TriggerSource trigger = TriggerSource::MIDI;
+    float swing = 0.f; // [0 : 1]
+    uint32_t patternSteps = 0;
+    LinkMode link = LinkMode::OFF;
+};
+
+} // namespace
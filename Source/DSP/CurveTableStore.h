@@ -0,0 +1,135 @@
+#pragma once
+#include <JuceHeader.h>
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "Curve.h"
+
+namespace duck::dsp {
+
+/**
+ * Process wide store of evaluated curve tables, so instances with the same curve share one table.
+ *
+ * Use it through juce::SharedResourcePointer<CurveTableStore>. Tables are keyed by the shape of the points
+ * and are immutable: editing a curve asks the store for the new table instead of writing into the shared one.
+ * The store only holds weak references, a table is freed as soon as the last instance stops using it.
+ *
+ * Tables have a fixed normalized resolution, independent of the curve length and sample rate. Playback
+ * reads them with a fractional phase, see read(), so changing the length doesn't touch the table.
+*/
+class CurveTableStore {
+public:
+    using Table = std::vector<float>;
+
+    /** The amount of steps a table is evaluated at, a table holds resolution + 1 values so the end is included. */
+    static constexpr size_t resolution = 4096;
+
+    /** @return The table for these points. Built only if no instance holds it yet. */
+    std::shared_ptr<const Table> get(const std::vector<duck::curve::Point<float>>& normalizedPoints) {
+        Key key = makeKey(normalizedPoints);
+
+        std::lock_guard<std::mutex> lock{storeMutex};
+        auto& bucket = tables[key.hash];
+
+        // drop tables nobody uses anymore while we're here
+        bucket.erase(std::remove_if(bucket.begin(), bucket.end(), [](const Entry& e){ return e.table.expired(); }), bucket.end());
+
+        for (const auto& entry : bucket) {
+            if (entry.key == key) {
+                if (auto table = entry.table.lock()) return table;
+            }
+        }
+
+        std::shared_ptr<const Table> table = build(normalizedPoints);
+        bucket.push_back(Entry{std::move(key), table});
+
+        // other buckets only get pruned when their hash comes up again, and a drag makes a new hash every step
+        if (++insertsSinceSweep >= sweepInterval) sweep();
+        return table;
+    }
+
+    /**
+     * @return The curve at phase, linearly interpolated between the table values.
+     * @param table resolution + 1 values, the data of a table from get().
+     * @param phase The normalized position in the curve, [0 : 1]. Anything past 1 reads the end.
+    */
+    static float read(const float* table, double phase) {
+        if (phase >= 1.0) return table[resolution];
+
+        const double position = std::max(phase, 0.0) * resolution;
+        const auto index = static_cast<size_t>(position);
+        const auto fraction = static_cast<float>(position - index);
+        return table[index] + fraction * (table[index+1] - table[index]);
+    }
+
+private:
+    struct Key {
+        uint64_t hash = 0;
+        std::vector<float> shape; // x, y and power of each point, the rest doesn't change the curve.
+
+        bool operator==(const Key& other) const { return hash == other.hash && shape == other.shape; }
+    };
+
+    struct Entry {
+        Key key;
+        std::weak_ptr<const Table> table;
+    };
+
+    /** The amount of new tables between two sweeps of the whole store. */
+    static constexpr size_t sweepInterval = 64;
+
+    /** Drops every expired entry, and the buckets that end up empty. Call with storeMutex held. */
+    void sweep() {
+        insertsSinceSweep = 0;
+        for (auto it = tables.begin(); it != tables.end();) {
+            auto& bucket = it->second;
+            bucket.erase(std::remove_if(bucket.begin(), bucket.end(), [](const Entry& e){ return e.table.expired(); }), bucket.end());
+            it = bucket.empty() ? tables.erase(it) : std::next(it);
+        }
+    }
+
+    static Key makeKey(const std::vector<duck::curve::Point<float>>& normalizedPoints) {
+        Key key;
+        key.shape.reserve(normalizedPoints.size() * 3);
+        for (const auto& point : normalizedPoints) {
+            key.shape.push_back(point.coords.x + 0.f); // + 0.f turns -0 into 0, so they hash the same
+            key.shape.push_back(point.coords.y + 0.f);
+            key.shape.push_back(point.power + 0.f);
+        }
+
+        // FNV-1a over the shape
+        uint64_t hash = 14695981039346656037ull;
+        auto mix = [&hash](const void* data, size_t size) {
+            auto bytes = static_cast<const unsigned char*>(data);
+            for (size_t i = 0; i < size; i++) {
+                hash ^= bytes[i];
+                hash *= 1099511628211ull;
+            }
+        };
+        mix(key.shape.data(), key.shape.size() * sizeof(float));
+        key.hash = hash;
+
+        return key;
+    }
+
+    static std::shared_ptr<const Table> build(const std::vector<duck::curve::Point<float>>& normalizedPoints) {
+        auto table = std::make_shared<Table>(resolution + 1, 1.0f); // full multiplier when there is no curve to evaluate
+        if (normalizedPoints.size() < 2) return table;
+
+        for (size_t i = 0; i <= resolution; i++) {
+            float normX = i / static_cast<float>(resolution);
+            (*table)[i] = duck::curve::CurveDisplay::getCurveAtNormalized(normX, normalizedPoints);
+        }
+        return table;
+    }
+
+    std::mutex storeMutex;
+    std::unordered_map<uint64_t, std::vector<Entry>> tables;
+    size_t insertsSinceSweep = 0;
+};
+
+} // namespace
@@ -0,0 +1,31 @@
+#pragma once
+#include <JuceHeader.h>
+#include "LookaheadDelay.h"
+
+namespace duck::dsp::kernels {
+
+/**
+ * Runs the lookahead over the channels while it's active, otherwise only keeps its history.
+ *
+ * Specialized for mono and stereo, so those have the channel loop unrolled, and for an inactive lookahead,
+ * which skips the per sample taps.
+ * @tparam Channels 1 or 2, 0 for any other amount.
+*/
+template <int Channels, bool Delayed>
+void delay(LookaheadDelay& lookahead, float* const* channels, int numChannels, int numSamples) {
+    if constexpr (Delayed) lookahead.process<Channels>(channels, numChannels, numSamples);
+    else lookahead.write<Channels>(channels, numChannels, numSamples);
+}
+
+using DelayKernel = void (*)(LookaheadDelay&, float* const*, int, int);
+
+/** @return The delay kernel for numChannels channels, picked once per block. */
+inline DelayKernel selectDelay(int numChannels, bool delayed) {
+    switch (numChannels) {
+        case 1:  return delayed ? &delay<1, true> : &delay<1, false>;
+        case 2:  return delayed ? &delay<2, true> : &delay<2, false>;
+        default: return delayed ? &delay<0, true> : &delay<0, false>;
+    }
+}
+
+} // namespace
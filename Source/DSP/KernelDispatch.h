@@ -0,0 +1,43 @@
+#pragma once
+#include <JuceHeader.h>
+#include "Simd/KernelSet.h"
+
+namespace duck::dsp::simd {
+
+/** @return If the cpu can run set, which has to be built for this platform. */
+inline bool canRun(const KernelSet* set) {
+    if (set == nullptr) return false;
+    if (set == getAvx512Kernels()) return juce::SystemStats::hasAVX512F() && juce::SystemStats::hasAVX2() && juce::SystemStats::hasFMA3();
+    if (set == getAvx2Kernels()) return juce::SystemStats::hasAVX2() && juce::SystemStats::hasFMA3();
+    if (set == getSse2Kernels()) return juce::SystemStats::hasSSE2();
+    return true; // scalar, and neon is part of every arm64 cpu
+}
+
+/** @return The set called name ("scalar", "sse2", "avx2", "avx512" or "neon"), nullptr if this cpu can't run it. */
+inline const KernelSet* findKernels(const juce::String& name) {
+    for (auto set : {getScalarKernels(), getSse2Kernels(), getAvx2Kernels(), getAvx512Kernels(), getNeonKernels()})
+        if (set != nullptr && name.equalsIgnoreCase(set->name))
+            return canRun(set) ? set : nullptr;
+    return nullptr;
+}
+
+/**
+ * @return The widest set this cpu runs, or the one the HDUCK_KERNEL environment variable names, for benchmarking.
+ * Picked once per process.
+ */
+inline const KernelSet& getDefaultKernels() {
+    static const KernelSet& kernels = [] () -> const KernelSet& {
+        const auto forced = juce::SystemStats::getEnvironmentVariable("HDUCK_KERNEL", {});
+        if (forced.isNotEmpty()) {
+            if (auto set = findKernels(forced)) return *set;
+            DBG("HDUCK_KERNEL=" << forced << " isn't available here, picking one from the cpu");
+        }
+
+        for (auto set : {getAvx512Kernels(), getAvx2Kernels(), getNeonKernels(), getSse2Kernels()})
+            if (canRun(set)) return *set;
+        return *getScalarKernels();
+    }();
+    return kernels;
+}
+
+} // namespace
@@ -0,0 +1,151 @@
+#pragma once
+#include <JuceHeader.h>
+#include <algorithm>
+
+namespace duck::dsp {
+
+/**
+ * The lookahead delay of every channel, changes its delay without clicks.
+ *
+ * The lines live in memory handed to prepare(), big enough for maxDelayMs at the prepared sample rate, so a new
+ * delay needs no new memory. A higher rate without a new prepare() clamps the delay to what fits. A new delay crossfades from the old read tap to the new one over fadeMs, a delay set
+ * during a crossfade starts once that one is done.
+*/
+class LookaheadDelay {
+public:
+    // the highest rate lines are sized for, higher ones are clamped to it.
+    static constexpr double maxSampleRate = 384000.0;
+    static constexpr double fadeMs = 10.0;
+
+    explicit LookaheadDelay(double maxDelayMs) : maxDelayMs(maxDelayMs) {}
+
+    /** @return The amount of floats prepare() needs for numChannels at sampleRate. */
+    size_t getRequiredSamples(int numChannels, double sampleRate) const {
+        return static_cast<size_t>(getLineLength(sampleRate)) * static_cast<size_t>(std::max(numChannels, 0));
+    }
+
+    /** Uses memory for the lines of numChannels at sampleRate, it needs getRequiredSamples(numChannels, sampleRate) floats and has to outlive the delay. */
+    void prepare(float* memory, int numChannels, double sampleRate) {
+        lines = memory;
+        amtChannels = std::max(numChannels, 0);
+        mask = getLineLength(sampleRate) - 1;
+        writePosition = 0;
+    }
+
+    /** Sets the crossfade length for the sample rate, and jumps to delaySamples without fading. The lines are cleared. */
+    void reset(double sampleRate, int delaySamples) {
+        if (lines != nullptr) std::fill(lines, lines + static_cast<size_t>(mask + 1) * static_cast<size_t>(amtChannels), 0.f);
+        fadeLength = std::max(1, static_cast<int>(sampleRate * fadeMs / 1000.0));
+        fadeRemaining = 0;
+        currentDelay = previousDelay = pendingDelay = clampDelay(delaySamples);
+    }
+
+    /** Fades to delaySamples, starting with the next block. */
+    void setDelay(int delaySamples) {
+        pendingDelay = clampDelay(delaySamples);
+    }
+
+    /** @return The delay that is being faded to or will be, in samples. */
+    int getDelay() const { return pendingDelay; }
+    int getNumChannels() const { return amtChannels; }
+    /** @return The longest delay in samples these lines can hold. */
+    int getMaxDelay() const { return mask; }
+
+    /** @return If the delay does anything, false while it's at 0 samples and not fading or about to. */
+    bool isActive() const { return currentDelay != 0 || pendingDelay != 0 || fadeRemaining > 0; }
+
+    /**
+     * Delays the first numChannels channels in place.
+     * @tparam Channels The amount of channels if it's known at compile time, 0 takes numChannels.
+     */
+    template <int Channels = 0>
+    void process(float* const* channels, int numChannels, int numSamples) {
+        if (fadeRemaining == 0 && pendingDelay != currentDelay) {
+            previousDelay = currentDelay;
+            currentDelay = pendingDelay;
+            fadeRemaining = fadeLength;
+        }
+
+        const int amtChannels = getAmountOfChannels<Channels>(numChannels);
+        for (int ch = 0; ch < amtChannels; ch++) {
+            auto line = getLine(ch);
+            auto samples = channels[ch];
+            int write = writePosition;
+            int remaining = fadeRemaining;
+
+            for (int i = 0; i < numSamples; i++) {
+                line[static_cast<size_t>(write)] = samples[i];
+                float out = line[static_cast<size_t>((write - currentDelay) & mask)];
+                if (remaining > 0) {
+                    // the weight of the old tap goes from 1 to 0
+                    const float oldWeight = static_cast<float>(remaining) / fadeLength;
+                    out += oldWeight * (line[static_cast<size_t>((write - previousDelay) & mask)] - out);
+                    remaining--;
+                }
+                samples[i] = out;
+                write = (write + 1) & mask;
+            }
+        }
+
+        writePosition = (writePosition + numSamples) & mask;
+        fadeRemaining = std::max(0, fadeRemaining - numSamples);
+    }
+
+    /**
+     * Only records the block into the lines and leaves it as it is, for while the delay isn't active.
+     * Keeps the history, so a delay set later fades in from what really played instead of from old samples.
+     */
+    template <int Channels = 0>
+    void write(const float* const* channels, int numChannels, int numSamples) {
+        jassert(!isActive());
+        const int length = mask + 1;
+        // only the last length samples fit in the lines
+        const int skip = std::max(0, numSamples - length);
+        const int start = (writePosition + skip) & mask;
+        const int count = numSamples - skip;
+        const int untilWrap = std::min(count, length - start);
+
+        const int amtChannels = getAmountOfChannels<Channels>(numChannels);
+        for (int ch = 0; ch < amtChannels; ch++) {
+            auto line = getLine(ch);
+            const float* samples = channels[ch] + skip;
+            std::copy(samples, samples + untilWrap, line + start);
+            std::copy(samples + untilWrap, samples + count, line);
+        }
+
+        writePosition = (writePosition + numSamples) & mask;
+    }
+
+private:
+    int clampDelay(int delaySamples) const { return std::clamp(delaySamples, 0, std::max(mask, 0)); }
+    float* getLine(int channel) const { return lines + static_cast<size_t>(channel) * static_cast<size_t>(mask + 1); }
+
+    template <int Channels>
+    int getAmountOfChannels(int numChannels) const {
+        if constexpr (Channels > 0) {
+            jassert(Channels <= amtChannels);
+            return Channels;
+        } else {
+            return std::min(numChannels, amtChannels);
+        }
+    }
+    // a power of two, so wrapping is a mask.
+    int getLineLength(double sampleRate) const {
+        const double rate = std::clamp(sampleRate, 1.0, maxSampleRate);
+        return juce::nextPowerOfTwo(static_cast<int>(std::ceil(maxDelayMs / 1000.0 * rate)) + 1);
+    }
+
+    double maxDelayMs;
+    float* lines = nullptr; // every channel after each other
+    int amtChannels = 0;
+    int mask = 0;
+    int writePosition = 0;
+
+    int currentDelay = 0;
+    int previousDelay = 0;
+    int pendingDelay = 0;
+    int fadeLength = 1;
+    int fadeRemaining = 0;
+};
+
+} // namespace
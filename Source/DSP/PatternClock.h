@@ -0,0 +1,71 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+
+namespace duck::dsp::pattern {
+
+/** A bar of sixteenth notes, bit n of the steps mask is step n. */
+constexpr int amtSteps = 16;
+constexpr double stepPpq = 0.25;
+constexpr uint32_t defaultSteps = 0x1111; // every beat
+
+/** What the host transport says about the block, see juce::AudioPlayHead::PositionInfo. */
+struct Transport {
+    double ppq = 0.0; // at the first sample of the block
+    double bpm = 120.0;
+    bool isLooping = false;
+    double loopStartPpq = 0.0;
+    double loopEndPpq = 0.0;
+};
+
+/** @return The ppq of step, odd steps are pushed back by up to half a step by swing [0 : 1]. */
+inline double getStepPpq(int64_t step, float swing) {
+    const bool isOffbeat = (step & 1) != 0;
+    return (static_cast<double>(step) + (isOffbeat ? 0.5 * swing : 0.0)) * stepPpq;
+}
+
+/**
+ * Calls onStep(sample) for every enabled step from startPpq up to endPpq, sample being firstSample plus the
+ * distance from startPpq. Goes over the steps in the range instead of checking every sample.
+ */
+template <typename Callback>
+void forEachStepIn(double startPpq, double endPpq, double samplesPerPpq, double firstSample,
+                   uint32_t steps, float swing, Callback&& onStep) {
+    // a swung step sits after its grid position, so start one step early
+    for (auto step = static_cast<int64_t>(std::floor(startPpq / stepPpq)) - 1;; step++) {
+        const double ppq = getStepPpq(step, swing);
+        if (ppq >= endPpq) break;
+        if (ppq < startPpq) continue;
+
+        const auto inBar = static_cast<int>(((step % amtSteps) + amtSteps) % amtSteps);
+        if ((steps >> inBar) & 1u)
+            onStep(static_cast<int>(firstSample + (ppq - startPpq) * samplesPerPpq));
+    }
+}
+
+/**
+ * Calls onStep(sample) for every enabled step in the block, in order. When the host loops inside the block the
+ * steps after the wrap continue from the loop start.
+ */
+template <typename Callback>
+void forEachStep(const Transport& transport, double sampleRate, int numSamples,
+                 uint32_t steps, float swing, Callback&& onStep) {
+    if (transport.bpm <= 0.0 || numSamples <= 0 || steps == 0) return;
+
+    const double samplesPerPpq = sampleRate * 60.0 / transport.bpm;
+    const double endPpq = transport.ppq + numSamples / samplesPerPpq;
+    const bool wraps = transport.isLooping && transport.loopEndPpq > transport.loopStartPpq
+                       && transport.ppq < transport.loopEndPpq && endPpq > transport.loopEndPpq;
+
+    if (!wraps) {
+        forEachStepIn(transport.ppq, endPpq, samplesPerPpq, 0.0, steps, swing, onStep);
+        return;
+    }
+
+    const double wrapSample = (transport.loopEndPpq - transport.ppq) * samplesPerPpq;
+    forEachStepIn(transport.ppq, transport.loopEndPpq, samplesPerPpq, 0.0, steps, swing, onStep);
+    forEachStepIn(transport.loopStartPpq, transport.loopStartPpq + (endPpq - transport.loopEndPpq),
+                  samplesPerPpq, wrapSample, steps, swing, onStep);
+}
+
+} // namespace
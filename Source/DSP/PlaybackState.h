@@ -0,0 +1,56 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
+namespace duck::dsp {
+
+/** Where the curve playback currently is, as seen by the GUI. */
+struct PlaybackState {
+    float position = 1.f; // normalized position within the curve, 1 when the curve has finished.
+    float gain = 1.f; // the lowest gain applied during the last processed block.
+
+    bool operator==(const PlaybackState& other) const { return position == other.position && gain == other.gain; }
+    bool operator!=(const PlaybackState& other) const { return !(*this == other); }
+};
+
+/**
+ * Hands the PlaybackState from the audio thread to the GUI without locks or messages.
+ *
+ * Both floats are packed into a single 64 bit atomic, so a reader never sees half of an update
+ * and the audio thread never waits on the reader.
+*/
+class PlaybackStatePublisher {
+public:
+    /** Called by the audio thread, once per block. */
+    void publish(const PlaybackState& state) noexcept {
+        packed.store(pack(state), std::memory_order_relaxed);
+    }
+
+    /** Can be polled from any thread. */
+    PlaybackState read() const noexcept {
+        return unpack(packed.load(std::memory_order_relaxed));
+    }
+
+private:
+    static uint64_t pack(const PlaybackState& state) noexcept {
+        uint32_t position, gain;
+        std::memcpy(&position, &state.position, sizeof(position));
+        std::memcpy(&gain, &state.gain, sizeof(gain));
+        return (static_cast<uint64_t>(position) << 32) | gain;
+    }
+
+    static PlaybackState unpack(uint64_t bits) noexcept {
+        const auto position = static_cast<uint32_t>(bits >> 32);
+        const auto gain = static_cast<uint32_t>(bits);
+        PlaybackState state;
+        std::memcpy(&state.position, &position, sizeof(position));
+        std::memcpy(&state.gain, &gain, sizeof(gain));
+        return state;
+    }
+
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "The playback state has to be published without locks");
+    std::atomic<uint64_t> packed{pack(PlaybackState{})};
+};
+
+} // namespace
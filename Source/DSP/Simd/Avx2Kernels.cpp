@@ -0,0 +1,91 @@
+#include "KernelSet.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#include <immintrin.h>
+
+namespace duck::dsp::simd {
+namespace {
+
+void multiply(float* samples, const float* gains, int numSamples) {
+    int i = 0;
+    for (; i + 8 <= numSamples; i += 8)
+        _mm256_storeu_ps(samples + i, _mm256_mul_ps(_mm256_loadu_ps(samples + i), _mm256_loadu_ps(gains + i)));
+    for (; i < numSamples; i++) samples[i] *= gains[i];
+}
+
+void multiplyConstant(float* samples, float gain, int numSamples) {
+    const __m256 g = _mm256_set1_ps(gain);
+    int i = 0;
+    for (; i + 8 <= numSamples; i += 8)
+        _mm256_storeu_ps(samples + i, _mm256_mul_ps(_mm256_loadu_ps(samples + i), g));
+    for (; i < numSamples; i++) samples[i] *= gain;
+}
+
+void multiplyWithDepth(float* samples, const float* fullGains, float depth, int numSamples) {
+    const float dry = 1.f - depth;
+    const __m256 vDry = _mm256_set1_ps(dry);
+    const __m256 vDepth = _mm256_set1_ps(depth);
+    int i = 0;
+    for (; i + 8 <= numSamples; i += 8) {
+        const __m256 gain = _mm256_fmadd_ps(vDepth, _mm256_loadu_ps(fullGains + i), vDry);
+        _mm256_storeu_ps(samples + i, _mm256_mul_ps(_mm256_loadu_ps(samples + i), gain));
+    }
+    for (; i < numSamples; i++) samples[i] *= dry + depth * fullGains[i];
+}
+
+// the table position of 4 samples from k, split in the index and the fraction after it.
+inline void getPositions(__m256d kd, __m256d phase, __m256d increment, __m256d halfStep, __m256d resolution,
+                         __m128i lastIndex, __m128i& index, __m128& fraction) {
+    const __m256d ramp = _mm256_mul_pd(halfStep, _mm256_mul_pd(kd, _mm256_add_pd(kd, _mm256_set1_pd(1.0))));
+    const __m256d p = _mm256_min_pd(_mm256_add_pd(_mm256_fmadd_pd(kd, increment, phase), ramp), _mm256_set1_pd(1.0));
+    const __m256d position = _mm256_mul_pd(p, resolution);
+    index = _mm_min_epi32(_mm256_cvttpd_epi32(position), lastIndex);
+    fraction = _mm256_cvtpd_ps(_mm256_sub_pd(position, _mm256_cvtepi32_pd(index)));
+}
+
+void readCurve(float* gains, const float* table, int resolution,
+               double phase, double increment, double incrementStep, float amount, int numSamples) {
+    const __m256d vPhase = _mm256_set1_pd(phase);
+    const __m256d vIncrement = _mm256_set1_pd(increment);
+    const __m256d halfStep = _mm256_set1_pd(incrementStep * 0.5);
+    const __m256d vResolution = _mm256_set1_pd(static_cast<double>(resolution));
+    const __m128i lastIndex = _mm_set1_epi32(resolution - 1);
+    const __m256 amt = _mm256_set1_ps(amount);
+    const __m256 one = _mm256_set1_ps(1.f);
+
+    int k = 0;
+    for (; k + 8 <= numSamples; k += 8) {
+        const __m256d kLow = _mm256_add_pd(_mm256_set1_pd(k), _mm256_setr_pd(0, 1, 2, 3));
+        const __m256d kHigh = _mm256_add_pd(kLow, _mm256_set1_pd(4));
+        __m128i indexLow, indexHigh;
+        __m128 fractionLow, fractionHigh;
+        getPositions(kLow, vPhase, vIncrement, halfStep, vResolution, lastIndex, indexLow, fractionLow);
+        getPositions(kHigh, vPhase, vIncrement, halfStep, vResolution, lastIndex, indexHigh, fractionHigh);
+
+        const __m256i index = _mm256_set_m128i(indexHigh, indexLow);
+        const __m256 fraction = _mm256_set_m128(fractionHigh, fractionLow);
+        const __m256 a = _mm256_i32gather_ps(table, index, 4);
+        const __m256 b = _mm256_i32gather_ps(table + 1, index, 4);
+        const __m256 value = _mm256_fmadd_ps(fraction, _mm256_sub_ps(b, a), a);
+        _mm256_storeu_ps(gains + k, _mm256_fnmadd_ps(amt, value, one));
+    }
+
+    if (k < numSamples)
+        getScalarKernels()->readCurve(gains + k, table, resolution,
+                                      getCurvePhase(phase, increment, incrementStep, k), increment + k * incrementStep,
+                                      incrementStep, amount, numSamples - k);
+}
+
+const KernelSet kernels{"avx2", &multiply, &multiplyConstant, &multiplyWithDepth, &readCurve};
+
+} // namespace
+
+const KernelSet* getAvx2Kernels() { return &kernels; }
+
+} // namespace
+
+#else
+
+const duck::dsp::simd::KernelSet* duck::dsp::simd::getAvx2Kernels() { return nullptr; }
+
+#endif
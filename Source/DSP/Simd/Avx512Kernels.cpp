@@ -0,0 +1,89 @@
+#include "KernelSet.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+
+namespace duck::dsp::simd {
+namespace {
+
+void multiply(float* samples, const float* gains, int numSamples) {
+    int i = 0;
+    for (; i + 16 <= numSamples; i += 16)
+        _mm512_storeu_ps(samples + i, _mm512_mul_ps(_mm512_loadu_ps(samples + i), _mm512_loadu_ps(gains + i)));
+    if (i < numSamples) {
+        const __mmask16 mask = static_cast<__mmask16>((1u << (numSamples - i)) - 1);
+        _mm512_mask_storeu_ps(samples + i, mask, _mm512_mul_ps(_mm512_maskz_loadu_ps(mask, samples + i), _mm512_maskz_loadu_ps(mask, gains + i)));
+    }
+}
+
+void multiplyConstant(float* samples, float gain, int numSamples) {
+    const __m512 g = _mm512_set1_ps(gain);
+    int i = 0;
+    for (; i + 16 <= numSamples; i += 16)
+        _mm512_storeu_ps(samples + i, _mm512_mul_ps(_mm512_loadu_ps(samples + i), g));
+    if (i < numSamples) {
+        const __mmask16 mask = static_cast<__mmask16>((1u << (numSamples - i)) - 1);
+        _mm512_mask_storeu_ps(samples + i, mask, _mm512_mul_ps(_mm512_maskz_loadu_ps(mask, samples + i), g));
+    }
+}
+
+void multiplyWithDepth(float* samples, const float* fullGains, float depth, int numSamples) {
+    const __m512 vDry = _mm512_set1_ps(1.f - depth);
+    const __m512 vDepth = _mm512_set1_ps(depth);
+    int i = 0;
+    for (; i + 16 <= numSamples; i += 16) {
+        const __m512 gain = _mm512_fmadd_ps(vDepth, _mm512_loadu_ps(fullGains + i), vDry);
+        _mm512_storeu_ps(samples + i, _mm512_mul_ps(_mm512_loadu_ps(samples + i), gain));
+    }
+    if (i < numSamples) {
+        const __mmask16 mask = static_cast<__mmask16>((1u << (numSamples - i)) - 1);
+        const __m512 gain = _mm512_fmadd_ps(vDepth, _mm512_maskz_loadu_ps(mask, fullGains + i), vDry);
+        _mm512_mask_storeu_ps(samples + i, mask, _mm512_mul_ps(_mm512_maskz_loadu_ps(mask, samples + i), gain));
+    }
+}
+
+void readCurve(float* gains, const float* table, int resolution,
+               double phase, double increment, double incrementStep, float amount, int numSamples) {
+    const __m512d vPhase = _mm512_set1_pd(phase);
+    const __m512d vIncrement = _mm512_set1_pd(increment);
+    const __m512d halfStep = _mm512_set1_pd(incrementStep * 0.5);
+    const __m512d vResolution = _mm512_set1_pd(static_cast<double>(resolution));
+    const __m512d one = _mm512_set1_pd(1.0);
+    const __m256i lastIndex = _mm256_set1_epi32(resolution - 1);
+    const __m256 amt = _mm256_set1_ps(amount);
+
+    // 8 samples at a time, the phases are doubles.
+    int k = 0;
+    for (; k + 8 <= numSamples; k += 8) {
+        const __m512d kd = _mm512_add_pd(_mm512_set1_pd(k), _mm512_setr_pd(0, 1, 2, 3, 4, 5, 6, 7));
+        const __m512d ramp = _mm512_mul_pd(halfStep, _mm512_mul_pd(kd, _mm512_add_pd(kd, one)));
+        const __m512d p = _mm512_min_pd(_mm512_add_pd(_mm512_fmadd_pd(kd, vIncrement, vPhase), ramp), one);
+        const __m512d position = _mm512_mul_pd(p, vResolution);
+        const __m256i index = _mm256_min_epi32(_mm512_cvttpd_epi32(position), lastIndex);
+        const __m256 fraction = _mm512_cvtpd_ps(_mm512_sub_pd(position, _mm512_cvtepi32_pd(index)));
+
+        const __m256 a = _mm256_i32gather_ps(table, index, 4);
+        const __m256 b = _mm256_i32gather_ps(table + 1, index, 4);
+        const __m256 value = _mm256_fmadd_ps(fraction, _mm256_sub_ps(b, a), a);
+        _mm256_storeu_ps(gains + k, _mm256_fnmadd_ps(amt, value, _mm256_set1_ps(1.f)));
+    }
+
+    if (k < numSamples)
+        getScalarKernels()->readCurve(gains + k, table, resolution,
+                                      getCurvePhase(phase, increment, incrementStep, k), increment + k * incrementStep,
+                                      incrementStep, amount, numSamples - k);
+}
+
+const KernelSet kernels{"avx512", &multiply, &multiplyConstant, &multiplyWithDepth, &readCurve};
+
+} // namespace
+
+const KernelSet* getAvx512Kernels() { return &kernels; }
+
+} // namespace
+
+#else
+
+const duck::dsp::simd::KernelSet* duck::dsp::simd::getAvx512Kernels() { return nullptr; }
+
+#endif
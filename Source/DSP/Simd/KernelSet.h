@@ -0,0 +1,48 @@
+#pragma once
+
+// no JuceHeader in here, the kernels are compiled with other instruction sets than the rest of the plugin.
+// for the same reason nothing in here has external linkage besides the getters, see getCurvePhase.
+
+namespace duck::dsp::simd {
+
+/**
+ * The hot loops of the processor, built once per instruction set. See KernelDispatch.h for picking one.
+ *
+ * Every set gives the same results up to float rounding, the scalar one is the reference.
+*/
+struct KernelSet {
+    const char* name;
+
+    /** samples[i] *= gains[i] */
+    void (*multiply)(float* samples, const float* gains, int numSamples);
+    /** samples[i] *= gain */
+    void (*multiplyConstant)(float* samples, float gain, int numSamples);
+    /** samples[i] *= 1 - depth * (1 - fullGains[i]), the gain at depth [0 : 1] of gains that duck all the way. */
+    void (*multiplyWithDepth)(float* samples, const float* fullGains, float depth, int numSamples);
+    /**
+     * gains[k] = 1 - amount * the table at phase + k * increment + incrementStep * k(k+1)/2, the phase stops at 1.
+     * That is the phase of the per sample loop that adds incrementStep to increment, then increment to the phase.
+     * @param table resolution + 1 values, read with linear interpolation.
+     */
+    void (*readCurve)(float* gains, const float* table, int resolution,
+                      double phase, double increment, double incrementStep, float amount, int numSamples);
+};
+
+// every set exists on every platform, the ones not built for it return nullptr.
+const KernelSet* getScalarKernels();
+const KernelSet* getSse2Kernels();
+const KernelSet* getAvx2Kernels();
+const KernelSet* getAvx512Kernels();
+const KernelSet* getNeonKernels();
+
+/**
+ * The phase of sample k, see KernelSet::readCurve.
+ * static, so every kernel file keeps its own copy. A shared inline one could be linked as the avx copy for everyone.
+ */
+static inline double getCurvePhase(double phase, double increment, double incrementStep, int k) {
+    const double kd = static_cast<double>(k);
+    const double p = phase + kd * increment + incrementStep * kd * (kd + 1.0) * 0.5;
+    return p < 1.0 ? p : 1.0;
+}
+
+} // namespace
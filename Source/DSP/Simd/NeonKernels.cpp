@@ -0,0 +1,74 @@
+#include "KernelSet.h"
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+#include <arm_neon.h>
+
+namespace duck::dsp::simd {
+namespace {
+
+void multiply(float* samples, const float* gains, int numSamples) {
+    int i = 0;
+    for (; i + 4 <= numSamples; i += 4)
+        vst1q_f32(samples + i, vmulq_f32(vld1q_f32(samples + i), vld1q_f32(gains + i)));
+    for (; i < numSamples; i++) samples[i] *= gains[i];
+}
+
+void multiplyConstant(float* samples, float gain, int numSamples) {
+    int i = 0;
+    for (; i + 4 <= numSamples; i += 4)
+        vst1q_f32(samples + i, vmulq_n_f32(vld1q_f32(samples + i), gain));
+    for (; i < numSamples; i++) samples[i] *= gain;
+}
+
+void multiplyWithDepth(float* samples, const float* fullGains, float depth, int numSamples) {
+    const float dry = 1.f - depth;
+    const float32x4_t vDry = vdupq_n_f32(dry);
+    int i = 0;
+    for (; i + 4 <= numSamples; i += 4) {
+        const float32x4_t gain = vmlaq_n_f32(vDry, vld1q_f32(fullGains + i), depth);
+        vst1q_f32(samples + i, vmulq_f32(vld1q_f32(samples + i), gain));
+    }
+    for (; i < numSamples; i++) samples[i] *= dry + depth * fullGains[i];
+}
+
+void readCurve(float* gains, const float* table, int resolution,
+               double phase, double increment, double incrementStep, float amount, int numSamples) {
+    // no gather, so the phases and the interpolation are vectorized and the table reads aren't.
+    alignas(16) float a[4], b[4], fractions[4];
+    const float32x4_t amt = vdupq_n_f32(amount);
+    const float32x4_t one = vdupq_n_f32(1.f);
+
+    int k = 0;
+    for (; k + 4 <= numSamples; k += 4) {
+        for (int lane = 0; lane < 4; lane++) {
+            const double position = getCurvePhase(phase, increment, incrementStep, k + lane) * resolution;
+            int index = static_cast<int>(position);
+            if (index > resolution - 1) index = resolution - 1;
+            a[lane] = table[index];
+            b[lane] = table[index+1];
+            fractions[lane] = static_cast<float>(position - index);
+        }
+        const float32x4_t va = vld1q_f32(a);
+        const float32x4_t value = vmlaq_f32(va, vld1q_f32(fractions), vsubq_f32(vld1q_f32(b), va));
+        vst1q_f32(gains + k, vmlsq_f32(one, amt, value));
+    }
+
+    if (k < numSamples)
+        getScalarKernels()->readCurve(gains + k, table, resolution,
+                                      getCurvePhase(phase, increment, incrementStep, k), increment + k * incrementStep,
+                                      incrementStep, amount, numSamples - k);
+}
+
+const KernelSet kernels{"neon", &multiply, &multiplyConstant, &multiplyWithDepth, &readCurve};
+
+} // namespace
+
+const KernelSet* getNeonKernels() { return &kernels; }
+
+} // namespace
+
+#else
+
+const duck::dsp::simd::KernelSet* duck::dsp::simd::getNeonKernels() { return nullptr; }
+
+#endif
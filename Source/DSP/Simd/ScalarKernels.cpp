@@ -0,0 +1,37 @@
+#include "KernelSet.h"
+
+namespace duck::dsp::simd {
+namespace {
+
+void multiply(float* samples, const float* gains, int numSamples) {
+    for (int i = 0; i < numSamples; i++) samples[i] *= gains[i];
+}
+
+void multiplyConstant(float* samples, float gain, int numSamples) {
+    for (int i = 0; i < numSamples; i++) samples[i] *= gain;
+}
+
+void multiplyWithDepth(float* samples, const float* fullGains, float depth, int numSamples) {
+    const float dry = 1.f - depth;
+    for (int i = 0; i < numSamples; i++) samples[i] *= dry + depth * fullGains[i];
+}
+
+void readCurve(float* gains, const float* table, int resolution,
+               double phase, double increment, double incrementStep, float amount, int numSamples) {
+    for (int k = 0; k < numSamples; k++) {
+        const double position = getCurvePhase(phase, increment, incrementStep, k) * resolution;
+        int index = static_cast<int>(position);
+        if (index > resolution - 1) index = resolution - 1; // the end reads table[resolution] with a fraction of 1
+        const float fraction = static_cast<float>(position - index);
+        const float value = table[index] + fraction * (table[index+1] - table[index]);
+        gains[k] = 1.f - amount * value;
+    }
+}
+
+const KernelSet kernels{"scalar", &multiply, &multiplyConstant, &multiplyWithDepth, &readCurve};
+
+} // namespace
+
+const KernelSet* getScalarKernels() { return &kernels; }
+
+} // namespace
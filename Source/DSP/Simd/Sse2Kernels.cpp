@@ -0,0 +1,76 @@
+#include "KernelSet.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#include <emmintrin.h>
+
+namespace duck::dsp::simd {
+namespace {
+
+void multiply(float* samples, const float* gains, int numSamples) {
+    int i = 0;
+    for (; i + 4 <= numSamples; i += 4)
+        _mm_storeu_ps(samples + i, _mm_mul_ps(_mm_loadu_ps(samples + i), _mm_loadu_ps(gains + i)));
+    for (; i < numSamples; i++) samples[i] *= gains[i];
+}
+
+void multiplyConstant(float* samples, float gain, int numSamples) {
+    const __m128 g = _mm_set1_ps(gain);
+    int i = 0;
+    for (; i + 4 <= numSamples; i += 4)
+        _mm_storeu_ps(samples + i, _mm_mul_ps(_mm_loadu_ps(samples + i), g));
+    for (; i < numSamples; i++) samples[i] *= gain;
+}
+
+void multiplyWithDepth(float* samples, const float* fullGains, float depth, int numSamples) {
+    const float dry = 1.f - depth;
+    const __m128 vDry = _mm_set1_ps(dry);
+    const __m128 vDepth = _mm_set1_ps(depth);
+    int i = 0;
+    for (; i + 4 <= numSamples; i += 4) {
+        const __m128 gain = _mm_add_ps(vDry, _mm_mul_ps(vDepth, _mm_loadu_ps(fullGains + i)));
+        _mm_storeu_ps(samples + i, _mm_mul_ps(_mm_loadu_ps(samples + i), gain));
+    }
+    for (; i < numSamples; i++) samples[i] *= dry + depth * fullGains[i];
+}
+
+void readCurve(float* gains, const float* table, int resolution,
+               double phase, double increment, double incrementStep, float amount, int numSamples) {
+    // no gather before avx2, so the phases and the interpolation are vectorized and the table reads aren't.
+    alignas(16) float a[4], b[4], fractions[4];
+    const __m128 amt = _mm_set1_ps(amount);
+    const __m128 one = _mm_set1_ps(1.f);
+
+    int k = 0;
+    for (; k + 4 <= numSamples; k += 4) {
+        for (int lane = 0; lane < 4; lane++) {
+            const double position = getCurvePhase(phase, increment, incrementStep, k + lane) * resolution;
+            int index = static_cast<int>(position);
+            if (index > resolution - 1) index = resolution - 1;
+            a[lane] = table[index];
+            b[lane] = table[index+1];
+            fractions[lane] = static_cast<float>(position - index);
+        }
+        const __m128 va = _mm_load_ps(a);
+        const __m128 value = _mm_add_ps(va, _mm_mul_ps(_mm_load_ps(fractions), _mm_sub_ps(_mm_load_ps(b), va)));
+        _mm_storeu_ps(gains + k, _mm_sub_ps(one, _mm_mul_ps(amt, value)));
+    }
+
+    if (k < numSamples)
+        getScalarKernels()->readCurve(gains + k, table, resolution,
+                                      getCurvePhase(phase, increment, incrementStep, k), increment + k * incrementStep,
+                                      incrementStep, amount, numSamples - k);
+}
+
+const KernelSet kernels{"sse2", &multiply, &multiplyConstant, &multiplyWithDepth, &readCurve};
+
+} // namespace
+
+const KernelSet* getSse2Kernels() { return &kernels; }
+
+} // namespace
+
+#else
+
+const duck::dsp::simd::KernelSet* duck::dsp::simd::getSse2Kernels() { return nullptr; }
+
+#endif
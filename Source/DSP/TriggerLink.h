@@ -0,0 +1,116 @@
+#pragma once
+#include <JuceHeader.h>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace duck::dsp {
+
+/**
+ * Shares note ons between instances, in this process or others on the machine, through a named ring in shared memory.
+ *
+ * The ring is a memory mapped file in the temp directory, so every instance that opens the same name sees the
+ * same triggers. Senders claim a slot with one atomic add, receivers read behind them without ever waiting: a slot
+ * that's still being written is picked up next block, one that was overwritten is skipped. Triggers are stamped with
+ * the host's sample time, so a receiver places them in its own block no matter when the sender ran.
+ *
+ * Opening maps the file, so do that on the message thread. send() and receive() are for the audio thread.
+*/
+class TriggerLink {
+public:
+    static constexpr uint32_t capacity = 256;
+
+    /** Maps the ring called name, creates it if no instance did yet. isValid() tells if that worked. */
+    explicit TriggerLink(const juce::String& name) {
+        const auto file = juce::File::getSpecialLocation(juce::File::tempDirectory).getChildFile("H-Duck-" + name + ".triggers");
+        if (!file.existsAsFile() && !file.create()) return;
+        if (file.getSize() < static_cast<juce::int64>(sizeof(Ring))) {
+            // appending, so an instance that already mapped the file keeps seeing the same one
+            juce::FileOutputStream out{file};
+            if (out.failedToOpen()) return;
+            out.writeRepeatedByte(0, sizeof(Ring) - static_cast<size_t>(file.getSize()));
+            out.flush();
+        }
+
+        mapping = std::make_unique<juce::MemoryMappedFile>(file, juce::Range<juce::int64>{0, static_cast<juce::int64>(sizeof(Ring))},
+                                                           juce::MemoryMappedFile::readWrite, false);
+        if (mapping->getData() == nullptr || mapping->getSize() < sizeof(Ring)) { mapping = nullptr; return; }
+
+        ring = static_cast<Ring*>(mapping->getData());
+        uint32_t expected = 0;
+        ring->magic.compare_exchange_strong(expected, magic);
+        if (ring->magic.load() != magic) { ring = nullptr; return; } // made by an incompatible version
+
+        readIndex = ring->writeIndex.load(std::memory_order_acquire); // only what's sent from now on
+    }
+
+    bool isValid() const { return ring != nullptr; }
+
+    /** Publishes a trigger at the host sample time. */
+    void send(int64_t timeInSamples) {
+        if (ring == nullptr) return;
+        const auto index = ring->writeIndex.fetch_add(1, std::memory_order_acq_rel);
+        auto& slot = ring->slots[index % capacity];
+        slot.sequence.store(2 * index + 1, std::memory_order_relaxed); // being written
+        // a reader that sees the new time sees the odd sequence too
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.timeInSamples.store(timeInSamples, std::memory_order_relaxed);
+        slot.sequence.store(2 * index + 2, std::memory_order_release);
+    }
+
+    /**
+     * Calls onTrigger(sample) for every trigger that falls in the block starting at the host sample time.
+     * Ones up to maxLateness samples before the block were sent after this instance's block ran and start at sample 0,
+     * older ones are dropped. Ones after the block stay for the next, unless they're further ahead than maxLateness
+     * too, then the host jumped back and they're dropped.
+     */
+    template <typename Callback>
+    void receive(int64_t blockTime, int numSamples, int64_t maxLateness, Callback&& onTrigger) {
+        if (ring == nullptr) return;
+
+        for (;;) {
+            auto& slot = ring->slots[readIndex % capacity];
+            const auto sequence = slot.sequence.load(std::memory_order_acquire);
+            if (sequence < 2 * readIndex + 2) return; // not written yet, or still being written
+            const auto time = slot.timeInSamples.load(std::memory_order_relaxed);
+            // the time is read before the sequence is checked again, so a sender that lapped this slot meanwhile is noticed
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence > 2 * readIndex + 2 || slot.sequence.load(std::memory_order_relaxed) != sequence) {
+                // a sender lapped this reader, continue with the oldest one still there
+                const auto written = ring->writeIndex.load(std::memory_order_acquire);
+                readIndex = written > capacity ? written - capacity : 0;
+                continue;
+            }
+
+            const auto offset = time - blockTime;
+            if (offset >= numSamples && offset < numSamples + maxLateness) return; // for a later block
+            if (offset >= -maxLateness && offset < numSamples)
+                onTrigger(static_cast<int>(std::max<int64_t>(offset, 0)));
+            readIndex++;
+        }
+    }
+
+private:
+    static constexpr uint32_t magic = 0x6b4c4448; // "HDLk" when read as little endian bytes
+
+    struct Slot {
+        std::atomic<uint64_t> sequence; // 2 * index + 1 while written, 2 * index + 2 once it's done
+        std::atomic<int64_t> timeInSamples;
+    };
+    // the layout of the file, zeroed memory is an empty ring.
+    struct Ring {
+        std::atomic<uint32_t> magic;
+        alignas(64) std::atomic<uint64_t> writeIndex;
+        alignas(64) Slot slots[capacity];
+    };
+    static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<int64_t>::is_always_lock_free,
+                  "the ring is shared between processes, that only works with lock free atomics");
+
+    std::unique_ptr<juce::MemoryMappedFile> mapping;
+    Ring* ring = nullptr;
+    uint64_t readIndex = 0;
+
+    JUCE_DECLARE_NON_COPYABLE(TriggerLink)
+};
+
+} // namespace
@@ -0,0 +1,45 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+
+namespace duck::dsp {
+
+/**
+ * Hands the latest value from one writer thread to one reader thread, without locks or allocations.
+ *
+ * The writer fills the back slot and swaps it with the middle one, the reader swaps the middle one with
+ * its front slot when something new was written. Neither side ever waits, the reader just keeps the
+ * value it has when nothing new came in. Values written between two reads are skipped.
+*/
+template <typename T>
+class TripleBuffer {
+    static_assert(std::is_trivially_copyable_v<T>, "the slots are copied while the other side might read, keep them POD");
+public:
+    TripleBuffer() = default;
+
+    /** Writer thread only. */
+    void write(const T& value) {
+        slots[back] = value;
+        back = state.exchange(static_cast<uint8_t>(back | newBit), std::memory_order_acq_rel) & indexMask;
+    }
+
+    /** Reader thread only. @return The last written value, or a default T if nothing was written yet. */
+    const T& read() {
+        if (state.load(std::memory_order_relaxed) & newBit)
+            front = state.exchange(front, std::memory_order_acq_rel) & indexMask;
+        return slots[front];
+    }
+
+private:
+    static constexpr uint8_t indexMask = 3;
+    static constexpr uint8_t newBit = 4;
+
+    std::array<T, 3> slots{};
+    std::atomic<uint8_t> state{1}; // the index of the middle slot, with newBit set if the reader hasn't taken it yet
+    uint8_t back = 0;  // writer owned
+    uint8_t front = 2; // reader owned
+};
+
+} // namespace
@@ -0,0 +1,87 @@
+#pragma once
+#include <JuceHeader.h>
+#include <array>
+#include <cstdint>
+#include "BlockSettings.h"
+#include "Simd/KernelSet.h"
+
+namespace duck::dsp {
+
+/**
+ * A fixed pool of curve cursors, one per note on that is still playing its curve, combined into one gain.
+ *
+ * Nothing is allocated, a note on with every voice busy steals the oldest one. A voice is free again once its
+ * phase reaches the end of the curve, with no voice playing the gain is the end of the curve.
+*/
+class VoicePool {
+public:
+    static constexpr int maxVoices = 8;
+
+    /** Starts a voice at the beginning of the curve. */
+    void trigger(CombineMode mode) {
+        if (mode == CombineMode::LATEST) stopAll();
+
+        Voice* target = &voices[0];
+        for (auto& voice : voices) {
+            if (!voice.isPlaying()) { target = &voice; break; }
+            if (voice.order < target->order) target = &voice;
+        }
+        target->phase = 0.0;
+        target->order = nextOrder++;
+    }
+
+    void stopAll() {
+        for (auto& voice : voices) voice.phase = 1.0;
+    }
+
+    bool isIdle() const {
+        for (const auto& voice : voices)
+            if (voice.isPlaying()) return false;
+        return true;
+    }
+
+    /** @return The phase of the newest playing voice, 1 if none play. */
+    double getNewestPhase() const {
+        const Voice* newest = nullptr;
+        for (const auto& voice : voices)
+            if (voice.isPlaying() && (newest == nullptr || voice.order > newest->order)) newest = &voice;
+        return newest != nullptr ? newest->phase : 1.0;
+    }
+
+    /**
+     * Writes the combined gain of numSamples samples at full depth and advances every voice, see simd::KernelSet::readCurve
+     * for the phase. Every voice is read with the simd kernel into scratch and combined with the ones before it.
+     * @param scratch Room for numSamples floats.
+     */
+    void render(const simd::KernelSet& simd, const float* table, int resolution, CombineMode mode,
+                double increment, double incrementStep, float* gains, float* scratch, int numSamples) {
+        int amtRendered = 0;
+        for (auto& voice : voices) {
+            if (!voice.isPlaying()) continue;
+
+            float* destination = amtRendered == 0 ? gains : scratch;
+            simd.readCurve(destination, table, resolution, voice.phase, increment, incrementStep, 1.f, numSamples);
+            if (amtRendered > 0) {
+                if (mode == CombineMode::MULTIPLY) simd.multiply(gains, scratch, numSamples);
+                else juce::FloatVectorOperations::min(gains, gains, scratch, numSamples);
+            }
+
+            voice.phase = simd::getCurvePhase(voice.phase, increment, incrementStep, numSamples);
+            amtRendered++;
+        }
+
+        if (amtRendered == 0)
+            juce::FloatVectorOperations::fill(gains, 1-table[resolution], numSamples);
+    }
+
+private:
+    struct Voice {
+        double phase = 1.0; // 1 is done
+        uint64_t order = 0; // higher is newer
+        bool isPlaying() const { return phase < 1.0; }
+    };
+    std::array<Voice, maxVoices> voices{};
+    uint64_t nextOrder = 1;
+};
+
+} // namespace
@@ -0,0 +1,65 @@
+#pragma once
+#include <JuceHeader.h>
+#include <functional>
+
+namespace duck {
+
+/**
+ * A static drawing layer that is rendered once into an image and then composited.
+ *
+ * The image is rendered at the physical pixel scale of the context it gets drawn to,
+ * so it stays sharp on high DPI displays. It only renders again after invalidate(),
+ * or when the bounds or the display scale changed.
+*/
+class CachedLayer {
+public:
+    /** Draws the layer content, in the coordinates of the component that owns the layer. */
+    using Renderer = std::function<void(juce::Graphics&)>;
+
+    CachedLayer(Renderer renderer)
+    : renderer(std::move(renderer))
+    {
+    }
+
+    /** Makes the next draw() render the layer again. */
+    void invalidate() { isDirty = true; }
+
+    /** Draws the cached image at bounds, renders it first if the cache is out of date. */
+    void draw(juce::Graphics& g, const juce::Rectangle<int>& bounds) {
+        if (bounds.isEmpty()) return;
+
+        const float scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+        if (isDirty || image.isNull() || bounds != cachedBounds || scale != cachedScale)
+            render(bounds, scale);
+
+        g.drawImageTransformed(image,
+            juce::AffineTransform::scale(1.f / scale).translated(static_cast<float>(bounds.getX()), static_cast<float>(bounds.getY())));
+    }
+
+private:
+    void render(const juce::Rectangle<int>& bounds, float scale) {
+        const int width = std::max(1, juce::roundToInt(bounds.getWidth() * scale));
+        const int height = std::max(1, juce::roundToInt(bounds.getHeight() * scale));
+
+        if (image.isNull() || image.getWidth() != width || image.getHeight() != height)
+            image = juce::Image(juce::Image::ARGB, width, height, true);
+        else
+            image.clear(image.getBounds());
+
+        juce::Graphics ig{image};
+        ig.addTransform(juce::AffineTransform::translation(static_cast<float>(-bounds.getX()), static_cast<float>(-bounds.getY())).scaled(scale));
+        renderer(ig);
+
+        cachedBounds = bounds;
+        cachedScale = scale;
+        isDirty = false;
+    }
+
+    Renderer renderer;
+    juce::Image image;
+    juce::Rectangle<int> cachedBounds;
+    float cachedScale = 1.f;
+    bool isDirty = true;
+};
+
+} // namespace
@@ -34,26 +34,121 @@ void duck::curve::Point<T>::setPowerClamped(float power) {
 
 
 
-duck::curve::CurveDisplay::CurveDisplay(duck::vt::ValueTree& tree)
-: vTree(tree), juce::ValueTree::Listener()
-{
-    curvePointsNormalized.push_back(duck::curve::Point<float>(0,1));
-    curvePointsNormalized.push_back(duck::curve::Point<float>(1,0));
+duck::curve::CurveModel::CurveModel() {
+    auto snapshot = std::make_shared<CurveSnapshot>();
+    snapshot->version = 1;
+    snapshot->points.push_back(duck::curve::Point<float>(0,1));
+    snapshot->points.push_back(duck::curve::Point<float>(1,0));
+    current = std::move(snapshot);
+}
+
+void duck::curve::CurveModel::publish(const std::vector<duck::curve::Point<float>>& points) {
+    const auto previous = get();
+
+    // nobody but us holds the spare anymore, so it can be written again without reallocating the points.
+    std::shared_ptr<CurveSnapshot> next = spare != nullptr && spare.use_count() == 1 ? std::move(spare) : std::make_shared<CurveSnapshot>();
+    next->version = previous->version + 1;
+    next->points.assign(points.begin(), points.end());
+
+    std::atomic_store(&current, std::shared_ptr<const CurveSnapshot>(next));
+    spare = std::const_pointer_cast<CurveSnapshot>(previous);
+    sendChangeMessage();
+}
+
+void duck::curve::CurveModel::loadFromTree(const duck::vt::ValueTree& vTree) {
+    auto points = readTree(vTree);
+    if (points.size() < 2) return;
+
+    publish(points);
+    syncedVersion = get()->version; // came from the tree, nothing to write back
+}
+
+std::vector<duck::curve::Point<float>> duck::curve::CurveModel::readTree(const duck::vt::ValueTree& vTree) {
+    const auto vtRoot = vTree.getRoot();
+    const auto curve = vtRoot.getChildWithName(vTree.getIDFromType(Property::T_CURVE_DATA));
+    const auto points = curve.getChildWithName(vTree.getIDFromType(Property::T_NORMALIZED_POINTS));
+    const auto amtPoints = points.getNumChildren();
+
+    std::vector<duck::curve::Point<float>> vec{};
+    if (amtPoints <= 0) return vec;
+
+    vec.reserve(amtPoints);
+    // vec.resize(amtPoints);
+    const auto xID = vTree.getIDFromType(Property::P_X);
+    const auto yID = vTree.getIDFromType(Property::P_Y);
+    const auto sizeID = vTree.getIDFromType(Property::P_SIZE);
+    const auto powerID = vTree.getIDFromType(Property::P_POWER);
+    const auto maxAbsPowerID = vTree.getIDFromType(Property::P_MAX_ABSOLUTE_POWER);
+
+    for (size_t i = 0; i < amtPoints; i++) {
+        const auto p = points.getChild(i);
+        auto duckP = duck::curve::Point<float>(p.getProperty(xID), p.getProperty(yID));
+        duckP.size = p.getProperty(sizeID);
+        duckP.power = p.getProperty(powerID);
+        duckP.maxAbsPower = p.getProperty(maxAbsPowerID);
+        vec.push_back(duckP);
+    }
+
+    return vec;
+}
 
-    // don't really need the listener, just push data and pull when created.
-    // tree.addListener(this);
-    auto newPoints = getTreeNormalizedPoints(vTree);
-    if (newPoints.size() >= 2) curvePointsNormalized = newPoints; 
+// builds the wanted curve tree, setChild diffs it into the existing one so unchanged points aren't recorded for undo.
+void duck::curve::CurveModel::syncToTree(duck::vt::ValueTree& vTree) {
+    using p = Property;
+
+    const auto snapshot = get();
+    if (!vTree.isValid() || snapshot->version == syncedVersion) return;
+
+    // the scratch tree isn't attached yet, so nothing here goes in the undo history
+    juce::ValueTree cd {vTree.getIDFromType(p::T_CURVE_DATA)};
+    juce::ValueTree np {vTree.getIDFromType(p::T_NORMALIZED_POINTS)};
+
+    for (const auto& point : snapshot->points) {
+        juce::ValueTree treePoint{vTree.getIDFromType(p::T_POINT)};
+        treePoint.setProperty(vTree.getIDFromType(p::P_POWER), {point.power}, nullptr);
+        treePoint.setProperty(vTree.getIDFromType(p::P_MAX_ABSOLUTE_POWER), {point.maxAbsPower}, nullptr);
+        treePoint.setProperty(vTree.getIDFromType(p::P_SIZE), {point.size}, nullptr);
+        treePoint.setProperty(vTree.getIDFromType(p::P_X), {point.coords.x}, nullptr);
+        treePoint.setProperty(vTree.getIDFromType(p::P_Y), {point.coords.y}, nullptr);
+
+        np.appendChild(treePoint, nullptr);
+    }
+
+    cd.appendChild(np, nullptr);
+    vTree.setChild(vTree.getIDFromType(p::T_CURVE_DATA), cd);
+    syncedVersion = snapshot->version;
+}
+
+
+// =================================================================
+
+
+duck::curve::CurveDisplay::CurveDisplay(duck::vt::ValueTree& tree, duck::curve::CurveModel& model)
+: vTree(tree), model(model), juce::ValueTree::Listener(),
+  curveLayer([this](juce::Graphics& g){ paintCurveLayer(g); }),
+  handleLayer([this](juce::Graphics& g){ paintHandleLayer(g); })
+{
+    // the model, not the tree, tells when the curve was replaced. the tree is only written once an edit is done.
+    const auto curve = model.get();
+    curvePointsNormalized = curve->points;
+    editedVersion = curve->version;
     updateResizedCurve();
+    model.addChangeListener(this);
+}
+
+duck::curve::CurveDisplay::~CurveDisplay() {
+    model.removeChangeListener(this);
+    if (publishPending) publishCurve(); // closed mid drag
+    setPlaybackSource(nullptr, nullptr, nullptr);
+    model.syncToTree(vTree);
 }
 
-void duck::curve::CurveDisplay::updateResizedCurve() {
+void duck::curve::CurveDisplay::updateResizedCurve(bool handlesChanged) {
     path = juce::Path();
     size_t i{};
 
     auto bounds = getLocalBounds();
-    curvePointsResizedBounds = std::vector<duck::curve::Point<float>>();
-    curvePointsResizedBounds.reserve(curvePointsNormalized.size());
+    curvePointsResizedBounds.clear(); // keeps its capacity, so dragging doesn't allocate
 
     for (const auto& point : curvePointsNormalized) {
         curvePointsResizedBounds.push_back(
@@ -73,15 +168,42 @@ void duck::curve::CurveDisplay::updateResizedCurve() {
         path.closeSubPath();
     }
 
-    onCurveUpdated();
+    curveLayer.invalidate();
+    if (handlesChanged) handleLayer.invalidate();
+
     repaint();
 }
 
+void duck::curve::CurveDisplay::publishCurve() {
+    publishPending = false;
+    model.publish(curvePointsNormalized);
+    editedVersion = model.get()->version;
+    onCurveUpdated();
+}
+
+void duck::curve::CurveDisplay::publishCurveOnNextFrame() {
+    if (playbackScheduler == nullptr) {
+        publishCurve();
+        return;
+    }
+    publishPending = true;
+    playbackScheduler->startAnimating(this);
+}
+
 void duck::curve::CurveDisplay::paint(juce::Graphics &g) {
+    const auto bounds = getLocalBounds();
+    curveLayer.draw(g, bounds);
+    handleLayer.draw(g, bounds);
+    paintPlayback(g);
+}
+
+void duck::curve::CurveDisplay::paintCurveLayer(juce::Graphics &g) const {
     g.setColour(juce::Colours::red);
     const auto type = juce::PathStrokeType(3.f);
     g.strokePath(path, type);
+}
 
+void duck::curve::CurveDisplay::paintHandleLayer(juce::Graphics &g) const {
     g.setColour(juce::Colours::white.withLightness(0.9f));
     for (const auto& point : curvePointsResizedBounds){
         float size = point.size;
@@ -89,6 +211,85 @@ void duck::curve::CurveDisplay::paint(juce::Graphics &g) {
     }
 }
 
+void duck::curve::CurveDisplay::paintPlayback(juce::Graphics &g) const {
+    if (playbackSource == nullptr) return;
+
+    // meter, fills from the top just like the curve does
+    const auto meter = getMeterBounds().toFloat();
+    const float reduction = std::clamp(1.f - shownPlayback.gain, 0.f, 1.f);
+    g.setColour(juce::Colours::white.withAlpha(0.15f));
+    g.fillRect(meter);
+    g.setColour(juce::Colours::orange);
+    g.fillRect(meter.withHeight(meter.getHeight() * reduction));
+
+    // playhead, hidden when the curve has finished
+    if (shownPlayback.position < 1.f) {
+        const float x = shownPlayback.position * getWidth();
+        g.setColour(juce::Colours::orange.withAlpha(0.8f));
+        g.drawLine(x, 0.f, x, static_cast<float>(getHeight()), 2.f);
+    }
+}
+
+void duck::curve::CurveDisplay::setPlaybackSource(const duck::dsp::PlaybackStatePublisher* source, duck::FrameScheduler* scheduler, juce::ChangeBroadcaster* triggers) {
+    if (playbackScheduler != nullptr) playbackScheduler->stopAnimating(this);
+    if (playbackTriggers != nullptr) playbackTriggers->removeChangeListener(this);
+
+    playbackSource = source;
+    playbackScheduler = scheduler;
+    playbackTriggers = triggers;
+    shownPlayback = duck::dsp::PlaybackState{};
+
+    if (playbackTriggers != nullptr) playbackTriggers->addChangeListener(this);
+    if (playbackSource != nullptr && playbackScheduler != nullptr) playbackScheduler->startAnimating(this);
+    repaint();
+}
+
+bool duck::curve::CurveDisplay::animationFrame(double nowMs) {
+    if (publishPending) publishCurve();
+    if (playbackSource == nullptr) return false;
+
+    const auto state = playbackSource->read();
+    if (state == shownPlayback) return state.position < 1.f;
+
+    // only the old and new playhead strip, and the meter when the gain moved.
+    if (state.position != shownPlayback.position) {
+        repaint(getPlayheadStrip(shownPlayback));
+        repaint(getPlayheadStrip(state));
+    }
+    if (state.gain != shownPlayback.gain) repaint(getMeterBounds());
+
+    shownPlayback = state;
+    return true;
+}
+
+void duck::curve::CurveDisplay::changeListenerCallback(juce::ChangeBroadcaster* source) {
+    if (source == &model) {
+        // the edits of this display have the version it already shows, and an edit in progress finishes first.
+        if (!isMouseButtonDown()) reloadFromModel();
+        return;
+    }
+    if (playbackSource != nullptr && playbackScheduler != nullptr) playbackScheduler->startAnimating(this);
+}
+
+void duck::curve::CurveDisplay::reloadFromModel() {
+    const auto curve = model.get();
+    if (curve->version == editedVersion) return;
+
+    curvePointsNormalized = curve->points;
+    editedVersion = curve->version;
+    updateResizedCurve();
+}
+
+juce::Rectangle<int> duck::curve::CurveDisplay::getPlayheadStrip(const duck::dsp::PlaybackState& state) const {
+    if (state.position >= 1.f) return {};
+    const int x = juce::roundToInt(state.position * getWidth());
+    return {x - 2, 0, 4, getHeight()};
+}
+
+juce::Rectangle<int> duck::curve::CurveDisplay::getMeterBounds() const {
+    return getLocalBounds().reduced(4).removeFromRight(6);
+}
+
 void duck::curve::CurveDisplay::resized() {
     auto localBounds = getLocalBounds();
     
@@ -147,11 +348,20 @@ void duck::curve::CurveDisplay::updatePathSection(const duck::curve::Point<float
     path.addLineSegment({lastPoint, to.coords}, 2.f);
 }
 
+void duck::curve::CurveDisplay::mouseDown(const juce::MouseEvent& event) {
+    // everything up to the next click is one undo step
+    vTree.beginTransaction();
+
+    // in case the change message of a replaced curve is still on its way
+    reloadFromModel();
+}
+
 void duck::curve::CurveDisplay::mouseDrag(const juce::MouseEvent& event) {
     auto offset = event.getOffsetFromDragStart();
     auto clickPos = event.mouseDownPosition;
     float yOffset = offset.y - lastDragOffset.y;
     auto bounds = getLocalBounds();
+    bool handlesChanged = true;
 
     // find the point to change the curve of
     int pointToPowerIndex = findPointPositionIndex(clickPos.x, curvePointsResizedBounds);
@@ -206,6 +416,7 @@ void duck::curve::CurveDisplay::mouseDrag(const juce::MouseEvent& event) {
 
     // change power
     else if (pointToPowerIndex != -1) {
+        handlesChanged = false;
         float multiplier = 0.05f;
         if (curvePointsNormalized[pointToPowerIndex].coords.y > curvePointsNormalized[pointToPowerIndex+1].coords.y) {
             // invert because the second point is higher up
@@ -218,13 +429,15 @@ void duck::curve::CurveDisplay::mouseDrag(const juce::MouseEvent& event) {
     }
 
     lastDragOffset = offset;
-    updateResizedCurve();
+    updateResizedCurve(handlesChanged);
+    publishCurveOnNextFrame();
 }
 
 void duck::curve::CurveDisplay::mouseUp(const juce::MouseEvent& event) {
     lastDragOffset = juce::Point<int>(0,0);
     isDraggingIndex = -1;
-    updateTree();
+    if (publishPending) publishCurve(); // the tree gets the last edit of the drag
+    model.syncToTree(vTree);
 }
 
 void duck::curve::CurveDisplay::mouseDoubleClick(const juce::MouseEvent& event) {
@@ -257,6 +470,7 @@ void duck::curve::CurveDisplay::mouseDoubleClick(const juce::MouseEvent& event)
     }
 
     updateResizedCurve();
+    publishCurve();
 }
 
 int duck::curve::CurveDisplay::findPointPositionIndex(float x, const std::vector<duck::curve::Point<float>>& points) {
@@ -331,61 +545,3 @@ void duck::curve::CurveDisplay::changePoint(juce::ValueTree& treeWhosePropertyHa
         }
     }
 }
-
-std::vector<duck::curve::Point<float>> duck::curve::CurveDisplay::getTreeNormalizedPoints(const duck::vt::ValueTree& vTree) {
-    using id = juce::Identifier;
-
-    const auto vtRoot = vTree.getRoot();
-    const auto curve = vtRoot.getChildWithName(vTree.getIDFromType(Property::T_CURVE_DATA).value_or(id{"undefined"}));
-    const auto points = curve.getChildWithName(vTree.getIDFromType(Property::T_NORMALIZED_POINTS).value_or(id{"undefined"}));
-    const auto amtPoints = points.getNumChildren();
-
-    std::vector<duck::curve::Point<float>> vec{};
-    if (amtPoints <= 0) return vec;
-
-    vec.reserve(amtPoints);
-    // vec.resize(amtPoints);
-    const auto xID = vTree.getIDFromType(Property::P_X).value_or(id{"undefined"});
-    const auto yID = vTree.getIDFromType(Property::P_Y).value_or(id{"undefined"});
-    const auto sizeID = vTree.getIDFromType(Property::P_SIZE).value_or(id{"undefined"});
-    const auto powerID = vTree.getIDFromType(Property::P_POWER).value_or(id{"undefined"});
-    const auto maxAbsPowerID = vTree.getIDFromType(Property::P_MAX_ABSOLUTE_POWER).value_or(id{"undefined"});
-
-    for (size_t i = 0; i < amtPoints; i++) {
-        const auto p = points.getChild(i);
-        auto duckP = duck::curve::Point<float>(p.getProperty(xID), p.getProperty(yID));
-        duckP.size = p.getProperty(sizeID);
-        duckP.power = p.getProperty(powerID);
-        duckP.maxAbsPower = p.getProperty(maxAbsPowerID);
-        vec.push_back(duckP);
-    }
-
-    return vec;
-}
-
-void duck::curve::CurveDisplay::updateTree() const {
-    using p = Property;
-    using id = juce::Identifier;
-
-    if (!vTree.isValid()) return;
-
-    auto undoManager = vTree.getUndoManager();
-
-
-    juce::ValueTree cd {vTree.getIDFromType(p::T_CURVE_DATA).value_or(id{"undefined"})};
-    juce::ValueTree np {vTree.getIDFromType(p::T_NORMALIZED_POINTS).value_or(id{"undefined"})};
-
-    for (const auto& point : curvePointsNormalized) {
-        juce::ValueTree treePoint{vTree.getIDFromType(p::T_POINT).value_or(id{"undefined"})};
-        treePoint.setProperty(vTree.getIDFromType(p::P_POWER).value_or(id{"undefined"}), {point.power}, undoManager);
-        treePoint.setProperty(vTree.getIDFromType(p::P_MAX_ABSOLUTE_POWER).value_or(id{"undefined"}), {point.maxAbsPower}, undoManager);
-        treePoint.setProperty(vTree.getIDFromType(p::P_SIZE).value_or(id{"undefined"}), {point.size}, undoManager);
-        treePoint.setProperty(vTree.getIDFromType(p::P_X).value_or(id{"undefined"}), {point.coords.x}, undoManager);
-        treePoint.setProperty(vTree.getIDFromType(p::P_Y).value_or(id{"undefined"}), {point.coords.y}, undoManager);
-
-        np.appendChild(treePoint, undoManager);
-    }
-
-    cd.appendChild(np, undoManager);
-    vTree.setChild(vTree.getIDFromType(p::T_CURVE_DATA).value_or("undefined"), cd);
-}
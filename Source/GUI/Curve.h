@@ -1,8 +1,12 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include <memory>
 #include <vector>
 #include "DuckValueTree.h"
+#include "CachedLayer.h"
+#include "PlaybackState.h"
+#include "FrameScheduler.h"
 
 namespace duck::curve {
 
@@ -27,17 +31,73 @@ struct Point {
 // =================================================================================
 
 
-class CurveDisplay : public juce::Component, public juce::ValueTree::Listener {
+// one immutable version of the curve, never changed once it's published.
+struct CurveSnapshot {
+    uint64 version = 0;
+    std::vector<duck::curve::Point<float>> points;
+};
+
+/**
+ * The authoritative curve, shared by the editor and the processor.
+ *
+ * Readers get the current snapshot without copying the points, edits publish a new snapshot with a higher version.
+ * The value tree is only a persisted copy, written by syncToTree when an edit is done instead of on every change.
+ * get() can be called from any thread, the rest is for the message thread.
+ * Every publish broadcasts a change, so displays pick up a curve replaced elsewhere, e.g. by loading a state.
+*/
+class CurveModel : public juce::ChangeBroadcaster {
+public:
+    CurveModel();
+
+    std::shared_ptr<const CurveSnapshot> get() const { return std::atomic_load(&current); }
+    /** Publishes points as the new version. Reuses the memory of an old snapshot nobody reads anymore. */
+    void publish(const std::vector<duck::curve::Point<float>>& points);
+    /** Replaces the curve with the points in the tree, e.g. after loading a state. Needs at least 2 points. */
+    void loadFromTree(const duck::vt::ValueTree& vTree);
+    /** Writes the curve into the tree if it changed since the last sync. */
+    void syncToTree(duck::vt::ValueTree& vTree);
+
+    static std::vector<duck::curve::Point<float>> readTree(const duck::vt::ValueTree& vTree);
+private:
+    std::shared_ptr<const CurveSnapshot> current;
+    std::shared_ptr<CurveSnapshot> spare; // the previous snapshot, reused by publish once only we hold it
+    uint64 syncedVersion = 0;
+};
+
+
+// =================================================================================
+
+
+class CurveDisplay : public juce::Component, public juce::ValueTree::Listener, public duck::FrameScheduler::Client, public juce::ChangeListener {
 private:
     void paint(juce::Graphics &g) override;
     void resized() override;
 
+    void mouseDown(const MouseEvent &event) override;
     void mouseDrag(const MouseEvent &event) override; 	
     void mouseUp(const MouseEvent &event) override;
     void mouseDoubleClick(const MouseEvent &event) override;
 
     // updates the curvePointsResizedBounds to match the new curvePointNormalized, then remakes the path and repaints.
-    void updateResizedCurve(); 
+    // @param handlesChanged set to false when only the curve powers changed, so the handle layer stays cached.
+    void updateResizedCurve(bool handlesChanged = true);
+    // publishes the edited curvePointsNormalized to the model, then calls onCurveUpdated.
+    void publishCurve();
+    // publishes on the next display frame, so a drag builds at most one curve table per frame. Right away without a scheduler.
+    void publishCurveOnNextFrame();
+    void paintCurveLayer(juce::Graphics& g) const;
+    void paintHandleLayer(juce::Graphics& g) const;
+    void paintPlayback(juce::Graphics& g) const;
+
+    // publishes a pending drag edit, then reads the playback source and repaints the playhead strip and meter if they changed.
+    // Stops once the curve is parked.
+    bool animationFrame(double nowMs) override;
+    // a trigger restarts polling, a model change shows the new curve.
+    void changeListenerCallback(juce::ChangeBroadcaster* source) override;
+    // shows the curve of the model if it was replaced outside of this display.
+    void reloadFromModel();
+    juce::Rectangle<int> getPlayheadStrip(const duck::dsp::PlaybackState& state) const;
+    juce::Rectangle<int> getMeterBounds() const;
     void updatePathSection(const duck::curve::Point<float>& from, const duck::curve::Point<float>& to);
     // looks for x in the BOUNDS of this component. -1 if not found
     static int findPointPositionIndex(float x, const std::vector<duck::curve::Point<float>>& points);
@@ -48,28 +108,43 @@ private:
     // value tree stuff
     void valueTreePropertyChanged(juce::ValueTree& treeWhosePropertyHasChanged, const juce::Identifier &property) override;
     void changePoint(juce::ValueTree& treeWhosePropertyHasChanged, const juce::Identifier& property);
-    void updateTree() const;
 public:
-    CurveDisplay(duck::vt::ValueTree& tree);
-    ~CurveDisplay(){updateTree();};
+    CurveDisplay(duck::vt::ValueTree& tree, duck::curve::CurveModel& model);
+    ~CurveDisplay();
     
     static float getCurveAtNormalized(float normalizedX, const std::vector<duck::curve::Point<float>>& normalizedPoints);
+    // called after every edit, the new curve is in the model.
     std::function<void()> onCurveUpdated = [](){};
     // @param x should be between the two points.
     static float interpolatePoints(const duck::curve::Point<float>& from, const duck::curve::Point<float>& to, float x);
-    // returns a copy of the current normalized points.
-    std::vector<duck::curve::Point<float>> getNormalizedPoints() const {return curvePointsNormalized;}
-    static std::vector<duck::curve::Point<float>> getTreeNormalizedPoints(const duck::vt::ValueTree& vTree);
+    /**
+     * Shows the playback position and gain reduction published by source, polled on every display frame while the curve plays.
+     * @param scheduler The clock that polls the source.
+     * @param triggers Broadcasts when the curve is triggered, to start polling again.
+    */
+    void setPlaybackSource(const duck::dsp::PlaybackStatePublisher* source, duck::FrameScheduler* scheduler, juce::ChangeBroadcaster* triggers);
 private:
     duck::vt::ValueTree& vTree;
+    duck::curve::CurveModel& model;
     juce::Path path;
-    // the normalized points which curvePointsResizedBounds is built from.
+    // the points being edited, loaded from the model and published back to it. curvePointsResizedBounds is built from these.
     std::vector<duck::curve::Point<float>> curvePointsNormalized;
+    uint64 editedVersion = 0; // the model version curvePointsNormalized was loaded from or published as
     // the points in the bounds of this component.
     std::vector<duck::curve::Point<float>> curvePointsResizedBounds;
     // previous update mouse pos offset while dragging
     juce::Point<int> lastDragOffset{0,0};
     int isDraggingIndex = -1; // -1 if not dragging.
+    bool publishPending = false; // a drag edit waiting for the next frame, see publishCurveOnNextFrame()
+
+    // the stroked path and the point handles, cached separately since a power drag only changes the path.
+    duck::CachedLayer curveLayer;
+    duck::CachedLayer handleLayer;
+
+    const duck::dsp::PlaybackStatePublisher* playbackSource = nullptr;
+    duck::FrameScheduler* playbackScheduler = nullptr;
+    juce::ChangeBroadcaster* playbackTriggers = nullptr;
+    duck::dsp::PlaybackState shownPlayback{};
 
 };
 
@@ -165,6 +165,9 @@ void subnite::Slider<T>::mouseExit(const juce::MouseEvent& e) {
 
 template <typename T>
 void subnite::Slider<T>::mouseDown(const juce::MouseEvent& e) {
+    if (vTree != nullptr) vTree->beginTransaction(); // the whole drag is one undo step
+    if (attachment != nullptr) attachment->beginGesture();
+
     if (e.mods.isLeftButtonDown()){
         setMouseCursor(juce::MouseCursor::NoCursor);
     }
@@ -180,6 +183,10 @@ void subnite::Slider<T>::mouseUp(const juce::MouseEvent& e) {
 
     updateValueTree();
     if (!updateTreeOnDrag) onValueChanged(displayedValue);
+    if (attachment != nullptr) {
+        if (!updateTreeOnDrag) attachment->setValueAsPartOfGesture(static_cast<float>(displayedValue));
+        attachment->endGesture();
+    }
 }
 
 template <typename T>
@@ -194,6 +201,7 @@ void subnite::Slider<T>::mouseDrag(const juce::MouseEvent& e) {
 
         lastDragOffset = offset;
         updateDisplayedValueChecked(updateTreeOnDrag);
+        if (attachment != nullptr && updateTreeOnDrag) attachment->setValueAsPartOfGesture(static_cast<float>(displayedValue));
         repaint();
 
         if (offset.getDistanceSquaredFrom({0,0}) > 50) {
@@ -207,12 +215,36 @@ template <typename T>
 void subnite::Slider<T>::mouseDoubleClick(const juce::MouseEvent& e) {
     if (e.mods.isLeftButtonDown()){
         setValue(defaultValue);
+        if (attachment != nullptr) attachment->setValueAsCompleteGesture(static_cast<float>(displayedValue)); // the click's own gesture already ended in mouseUp
         repaint();
     }
 
     updateValueTree();
 }
 
+template <typename T>
+void subnite::Slider<T>::setParameter(juce::RangedAudioParameter* parameter) {
+    attachment = nullptr;
+    this->parameter = parameter;
+    if (parameter == nullptr) return;
+
+    const auto& range = parameter->getNormalisableRange();
+    minValue = static_cast<T>(range.start);
+    maxValue = static_cast<T>(range.end);
+    defaultValue = static_cast<T>(parameter->convertFrom0to1(parameter->getDefaultValue()));
+    normalizedToDisplayed = [parameter](double normalizedValue) {
+        return static_cast<T>(parameter->convertFrom0to1(static_cast<float>(normalizedValue)));
+    };
+
+    // called on the message thread, for changes by the host and the initial value.
+    attachment = std::make_unique<juce::ParameterAttachment>(*parameter, [this](float newValue) {
+        normalizedRawValue = this->parameter->convertTo0to1(newValue);
+        updateDisplayedValueChecked(false);
+        repaint();
+    });
+    attachment->sendInitialUpdate();
+}
+
 template <typename T>
 void subnite::Slider<T>::setValueTree(subnite::vt::ValueTreeBase* parentTree, juce::Identifier uniqueSliderTreeID,
 juce::Identifier rawNormalizedValueID, juce::Identifier displayValueID, juce::Identifier minValueID, juce::Identifier maxValueID) {
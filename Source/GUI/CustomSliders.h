@@ -1,6 +1,7 @@
 #pragma once
 #include <JuceHeader.h>
 #include <functional>
+#include <memory>
 #include <string>
 #include "ValueTreeManager.h"
 
@@ -103,6 +104,15 @@ public:
     /** Updates the slider properties in the value tree if it exists. */
     void updateValueTree();
 
+    /**
+     * Binds the slider to a host parameter, instead of a value tree.
+     *
+     * The range and default come from the parameter, normalizedToDisplayed is replaced by the parameter's range,
+     * and dragging sends one gesture to the host. Host automation moves the slider.
+     * @param parameter The parameter to follow, nullptr unbinds. Has to outlive the slider.
+     */
+    void setParameter(juce::RangedAudioParameter* parameter);
+
     /** Sets up the value tree, and updates this component from its values. */
     void setValueTree(subnite::vt::ValueTreeBase* parentTree, juce::Identifier uniqueSliderTreeID, juce::Identifier rawNormalizedValueID, juce::Identifier displayValueID, juce::Identifier minValueID, juce::Identifier maxValueID);
 
@@ -126,6 +136,10 @@ private:
 
     std::string prefix = "";
     std::string postfix = "";
+
+    /** The bound parameter, see setParameter. */
+    juce::RangedAudioParameter* parameter = nullptr;
+    std::unique_ptr<juce::ParameterAttachment> attachment;
     
     /** Used in paint. @see paint */
     bool isHovering = false;
@@ -142,11 +156,11 @@ private:
     void mouseEnter(const juce::MouseEvent &event) override;
     /** Stops displaying the value. @see mouseEnter */
     void mouseExit(const juce::MouseEvent &event) override;
-    /** Hides mouse */
+    /** Hides mouse and starts a new undo transaction. */
     void mouseDown(const juce::MouseEvent &event) override;
     /** Shows mouse again and updates the tree. */
     void mouseUp(const juce::MouseEvent &event) override;
-    /** Updates the tree and value if updateValueOnHover = true. */
+    /** Updates the tree and value if updateTreeOnDrag = true. */
     void mouseDrag(const juce::MouseEvent &event) override;
     /** Resets the slider value to defaultValue. */
     void mouseDoubleClick(const juce::MouseEvent &event) override; // reset to default
@@ -0,0 +1,86 @@
+#pragma once
+#include <JuceHeader.h>
+#include <algorithm>
+#include <vector>
+
+namespace duck {
+
+/**
+ * One display synced animation clock, shared by all animated components of an editor.
+ *
+ * Driven by a juce::VBlankAttachment on the host component, and only attached while at least one
+ * client is animating, so an editor without animations doesn't get any callbacks at all.
+*/
+class FrameScheduler : private juce::AsyncUpdater {
+public:
+    class Client {
+    public:
+        virtual ~Client() = default;
+        /**
+         * Called once per display frame while animating.
+         * @param nowMs The wall time in milliseconds, derive animation frames from this instead of counting calls.
+         * @return false when the client stopped animating, call startAnimating() to resume.
+        */
+        virtual bool animationFrame(double nowMs) = 0;
+    };
+
+    FrameScheduler(juce::Component& host)
+    : host(host)
+    {
+    }
+    ~FrameScheduler() {
+        cancelPendingUpdate();
+        vblank.reset();
+    }
+
+    /** Calls client on every display frame until it returns false or stopAnimating() is called. */
+    void startAnimating(Client* client) {
+        jassert(client != nullptr);
+        if (std::find(clients.begin(), clients.end(), client) == clients.end())
+            clients.push_back(client);
+
+        if (vblank == nullptr)
+            vblank = std::make_unique<juce::VBlankAttachment>(&host, [this](){ onVBlank(); });
+    }
+
+    /** Safe to call from within a frame callback, and from the client destructor. */
+    void stopAnimating(Client* client) {
+        auto it = std::find(clients.begin(), clients.end(), client);
+        if (it == clients.end()) return;
+
+        if (isDispatching) *it = nullptr; // removed after the current frame
+        else clients.erase(it);
+
+        if (std::none_of(clients.begin(), clients.end(), [](Client* c){ return c != nullptr; }))
+            triggerAsyncUpdate();
+    }
+
+    static double now() { return juce::Time::getMillisecondCounterHiRes(); }
+
+private:
+    void onVBlank() {
+        const double nowMs = now();
+
+        isDispatching = true;
+        // by index, a client may start another one from its callback
+        for (size_t i = 0; i < clients.size(); i++) {
+            if (clients[i] != nullptr && !clients[i]->animationFrame(nowMs))
+                clients[i] = nullptr;
+        }
+        isDispatching = false;
+
+        clients.erase(std::remove(clients.begin(), clients.end(), nullptr), clients.end());
+        if (clients.empty()) triggerAsyncUpdate(); // can't detach from within the vblank callback itself
+    }
+
+    void handleAsyncUpdate() override {
+        if (clients.empty()) vblank.reset();
+    }
+
+    juce::Component& host;
+    std::vector<Client*> clients;
+    std::unique_ptr<juce::VBlankAttachment> vblank;
+    bool isDispatching = false;
+};
+
+} // namespace
@@ -0,0 +1,104 @@
+#pragma once
+#include <JuceHeader.h>
+#include <map>
+#include <memory>
+#include "GifSettings.h"
+#include "PngGifFrameViewer.h"
+
+namespace duck {
+
+/**
+ * Parsed gif settings and decoded sprite sheets, shared by every plugin instance in the process.
+ *
+ * Use it through juce::SharedResourcePointer<GifResourceCache>. Entries are keyed by file path and
+ * modification time, so editing gifs.json or a sheet on disk is picked up by the next editor.
+ * Sheets nobody uses anymore are evicted, least recently used first, once the memory budget is exceeded.
+ * Everything except the loader thread pool can be called from any thread.
+*/
+class GifResourceCache {
+public:
+    GifResourceCache() = default;
+
+    /** @return The settings of the active gif in jsonFile, the gif called fallbackName if none is set. */
+    std::shared_ptr<const GifSettings> getActiveGifSettings(const File& jsonFile, const std::string& fallbackName) {
+        const juce::ScopedLock lock{cacheLock};
+
+        const auto key = makeKey(jsonFile);
+        if (activeSettings == nullptr || key != activeSettingsKey) {
+            auto settings = std::make_shared<GifSettings>();
+            var rootVar = JSON::parse(jsonFile);
+            settings->fileName = GifSettings::getActiveGifName(rootVar, fallbackName);
+            auto syncResult = settings->readFrom(rootVar);
+            jassert(syncResult == GifSyncResult::Success);
+
+            activeSettings = std::move(settings);
+            activeSettingsKey = key;
+        }
+        return activeSettings;
+    }
+
+    /** @return The decoded sheet, decodes it first if no other instance did yet. */
+    std::shared_ptr<PngGifFrameViewer> getFrames(const File& sheetFile, const GifSettings& settings) {
+        const juce::ScopedLock lock{cacheLock};
+
+        auto key = makeKey(sheetFile) + "|" + String(settings.rows) + "x" + String(settings.columns) + "x" + String(settings.totalAmount);
+        auto it = sheets.find(key);
+        if (it == sheets.end()) {
+            auto frames = std::make_shared<PngGifFrameViewer>(sheetFile, settings.rows, settings.columns, settings.totalAmount);
+            it = sheets.emplace(key, Entry{std::move(frames), 0}).first;
+        }
+        it->second.lastUse = ++useCounter;
+
+        auto frames = it->second.frames;
+        trim();
+        return frames;
+    }
+
+    /** Sets how many bytes of unused sheets and scaled frames are kept. */
+    void setMemoryBudget(size_t bytes) {
+        const juce::ScopedLock lock{cacheLock};
+        memoryBudget = bytes;
+        trim();
+    }
+
+    /** The single background thread that all editors load their gifs on. */
+    juce::ThreadPool& getLoader() { return loader; }
+
+private:
+    struct Entry {
+        std::shared_ptr<PngGifFrameViewer> frames;
+        uint32 lastUse = 0;
+    };
+
+    static String makeKey(const File& file) {
+        return file.getFullPathName() + "@" + String(file.getLastModificationTime().toMilliseconds());
+    }
+
+    // evicts unused sheets, least recently used first, until the cache fits in the budget again.
+    void trim() {
+        for (;;) {
+            size_t total = 0;
+            auto oldestUnused = sheets.end();
+            for (auto it = sheets.begin(); it != sheets.end(); it++) {
+                total += it->second.frames->getMemoryUsage();
+                const bool isUnused = it->second.frames.use_count() == 1; // only held by this cache
+                if (isUnused && (oldestUnused == sheets.end() || it->second.lastUse < oldestUnused->second.lastUse))
+                    oldestUnused = it;
+            }
+
+            if (total <= memoryBudget || oldestUnused == sheets.end()) return;
+            sheets.erase(oldestUnused);
+        }
+    }
+
+    juce::CriticalSection cacheLock;
+    std::map<String, Entry> sheets;
+    std::shared_ptr<const GifSettings> activeSettings;
+    String activeSettingsKey;
+    uint32 useCounter = 0;
+    size_t memoryBudget = 64 * 1024 * 1024;
+
+    juce::ThreadPool loader{juce::ThreadPoolOptions{}.withThreadName("H-Duck gif loader").withNumberOfThreads(1)};
+};
+
+}
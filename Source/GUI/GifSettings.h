@@ -0,0 +1,90 @@
+#pragma once
+#include <JuceHeader.h>
+#include <string>
+
+namespace duck {
+enum class GifSyncResult {
+    RootNotFound,
+    GifNotFound,
+    Success
+};
+
+/**
+ * The settings of one gif in gifs.json, see PackagedResources/gifs.json for what they mean.
+ * Properties that are missing in the json keep the defaults below.
+*/
+struct GifSettings {
+    std::string fileName;
+    size_t rows{1}, columns{1}, totalAmount{1};
+    juce::Range<size_t> idleFrameRange = juce::Range<size_t>(0, 1);
+    juce::Range<size_t> triggerFrameRange = juce::Range<size_t>(2, 6);
+    bool bounceBack = true; /** after the trigger, will then bounce back from end to beginning before going to idle */
+    float idleFPS{1}, triggerFPS{7};
+
+    /** @return The "active_gif" in the root of gifs.json, or fallback if it isn't set. */
+    static std::string getActiveGifName(const juce::var& rootVar, const std::string& fallback) {
+        DynamicObject* rootObject = rootVar.getDynamicObject();
+        if (rootObject == nullptr) return fallback;
+
+        auto gifVar = rootObject->getProperty(juce::Identifier{"active_gif"});
+        if (!gifVar.isVoid() && gifVar.isString()) return gifVar.toString().toStdString();
+        return fallback;
+    }
+
+    /** Reads the settings of the gif called fileName from the root of gifs.json. */
+    GifSyncResult readFrom(const juce::var& rootVar) {
+        DynamicObject* rootObject = rootVar.getDynamicObject();
+        if (rootObject == nullptr) return GifSyncResult::RootNotFound;
+
+        // get the gif object in question
+        auto gifVar = rootObject->getProperty(juce::Identifier{fileName});
+        DynamicObject* gifObject = gifVar.getDynamicObject();
+        if (gifObject == nullptr) return GifSyncResult::GifNotFound;
+
+        // get the properties
+        tryAssignInt<size_t>(gifObject, "rows", rows);
+        tryAssignInt<size_t>(gifObject, "columns", columns);
+        tryAssignInt<size_t>(gifObject, "total_frames", totalAmount);
+
+        size_t idleX{idleFrameRange.getStart()}, idleY{idleFrameRange.getEnd()}, triggerX{triggerFrameRange.getStart()}, triggerY{triggerFrameRange.getEnd()};
+        tryAssignInt<size_t>(gifObject, "idle_start_frame_index", idleX);
+        tryAssignInt<size_t>(gifObject, "idle_end_frame_index", idleY);
+        tryAssignInt<size_t>(gifObject, "trigger_start_index", triggerX);
+        tryAssignInt<size_t>(gifObject, "trigger_end_index", triggerY);
+
+        idleFrameRange = juce::Range<size_t>{idleX, idleY};
+        triggerFrameRange = juce::Range<size_t>{triggerX, triggerY};
+
+        tryAssignDouble<float>(gifObject, "idle_fps", idleFPS);
+        tryAssignDouble<float>(gifObject, "trigger_fps", triggerFPS);
+
+        auto bounceVar = gifObject->getProperty(juce::Identifier{"bounce_back"});
+        if (!bounceVar.isVoid() && bounceVar.isBool()) {
+            bool value = bounceVar.operator bool();
+            bounceBack = value;
+        }
+
+        return GifSyncResult::Success;
+    }
+
+private:
+    template<typename T>
+    static void tryAssignInt(juce::DynamicObject* obj, const char* name, T& assignTo) {
+        auto var = obj->getProperty(juce::Identifier{name});
+        if (!var.isVoid() && var.isInt()) {
+            int value = var.operator int();
+            assignTo = static_cast<T>(value);
+        }
+    }
+
+    template<typename T>
+    static void tryAssignDouble(juce::DynamicObject* obj, const char* name, T& assignTo) {
+        auto var = obj->getProperty(juce::Identifier{name});
+        if (!var.isVoid() && (var.isInt() || var.isDouble() || var.isInt64())) {
+            float value = var.operator float();
+            assignTo = static_cast<T>(value);
+        }
+    }
+};
+
+}
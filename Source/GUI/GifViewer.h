@@ -1,63 +1,76 @@
 #pragma once
 #include <JuceHeader.h>
 #include "PngGifFrameViewer.h"
+#include "FrameScheduler.h"
+#include "GifSettings.h"
+#include "GifResourceCache.h"
 
 namespace duck {
-enum class GifSyncResult {
-    RootNotFound,
-    GifNotFound,
-    Success
-};
 
-class GifViewer : public juce::Component, public juce::Timer, public juce::ChangeListener {
+/**
+ * Shows the "active_gif" from gifs.json, and plays its trigger animation when the broadcaster fires.
+ *
+ * The json and the sprite sheet are read on a background thread, so constructing this returns immediately.
+ * Nothing is drawn until the gif is loaded. Both come from the process wide GifResourceCache, so instances
+ * showing the same gif share one decoded sheet.
+*/
+class GifViewer : public juce::Component, public duck::FrameScheduler::Client, public juce::ChangeListener, private juce::AsyncUpdater {
 public:
-    GifViewer(const std::string& fileName, juce::ChangeBroadcaster* sidechainTriggerBroadcast = nullptr)
-    : fileName(fileName)
+    GifViewer(duck::FrameScheduler& scheduler, juce::ChangeBroadcaster* sidechainTriggerBroadcast = nullptr)
+    : scheduler(scheduler)
     {
-        auto syncResult = syncJSONData();
-        jassert(syncResult == GifSyncResult::Success);
-        gif = std::make_unique<PngGifFrameViewer>(getUserGif(fileName), rows, columns, totalAmount);
-        idleAnimation();
+        setInterceptsMouseClicks(false, false);
         if (sidechainTriggerBroadcast != nullptr) {
             broadcaster = sidechainTriggerBroadcast;
             broadcaster->addChangeListener(this);
         }
 
+        cache->getLoader().addJob(&loadJob, false);
     }
     ~GifViewer() {
-        stopTimer();
+        cache->getLoader().removeJob(&loadJob, true, -1);
+        cancelPendingUpdate();
+        scheduler.stopAnimating(this);
         if (broadcaster != nullptr) broadcaster->removeChangeListener(this);
     }
 
     void paint(juce::Graphics &g) override {
-        auto img = gif->getFrame(currentFrameIdx);
-        g.drawImage(img, getLocalBounds().toFloat(), RectanglePlacement(RectanglePlacement::centred));
+        if (gif == nullptr) return; // still loading
+
+        const auto area = gif->getFittedBounds(getLocalBounds());
+        if (area.isEmpty()) return;
+
+        // the frame is already at the physical size, so this ends up as a plain blit.
+        const float scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+        const auto& img = gif->getScaledFrame(currentFrameIdx, area, scale);
+        g.drawImageTransformed(img, AffineTransform::scale(1.f / scale).translated(static_cast<float>(area.getX()), static_cast<float>(area.getY())));
     }
 
-    void timerCallback() override {
-        if (isIdle) {
-            // we can assume the timer is on idle fps
-            handleFrameIndex(idleFrameRange);
-            
-        } else {
-            // we can assume the timer is on trigger fps
-            handleFrameIndex(triggerFrameRange);
+    bool animationFrame(double nowMs) override {
+        if (gif == nullptr) return false;
+
+        // the frame follows from the elapsed time, so late or dropped display frames don't slow it down
+        const float fps = isIdle ? settings.idleFPS : settings.triggerFPS;
+        const auto dueSteps = static_cast<int64>((nowMs - animationStartMs) * fps / 1000.0);
+        const auto behind = dueSteps - stepsTaken;
+        if (behind > maxCatchUpSteps) stepsTaken = dueSteps - maxCatchUpSteps; // after a long stall, don't replay everything
+
+        while (stepsTaken < dueSteps) {
+            stepsTaken++;
+            if (advanceFrame()) break; // switched to idle, which restarted the clock
         }
 
-        // check for frame change and repaint
-        if (previousFrameIdx != currentFrameIdx) repaint();
+        // only repaint the pixels that differ between the frames
+        if (previousFrameIdx != currentFrameIdx)
+            repaint(gif->getChangedArea(previousFrameIdx, currentFrameIdx, gif->getFittedBounds(getLocalBounds())));
         previousFrameIdx = currentFrameIdx;
 
-        // check for end of trigger
-        bool triggerMaybeCompleted = bounceBack ? isReversed && !isIdle : !isReversed && !isIdle;
-        if (triggerMaybeCompleted){
-            size_t lastIndex = bounceBack ? triggerFrameRange.getStart() : triggerFrameRange.getEnd();
-            if (currentFrameIdx == lastIndex) idleAnimation();
-        }
+        // a single frame idle animation has nothing to animate until the next trigger
+        return !isIdle || settings.idleFrameRange.getLength() > 0;
     }
 
-    void changeListenerCallback (ChangeBroadcaster *source) {
-        triggerAnimation();
+    void changeListenerCallback (ChangeBroadcaster *source) override {
+        if (gif != nullptr) triggerAnimation();
     }
 
     static File getUserResources() {
@@ -86,6 +99,55 @@ private:
     }
 
 
+    /** Runs on the loader thread. */
+    void loadActiveGif() {
+        auto loaded = std::make_unique<LoadedGif>();
+        loaded->settings = cache->getActiveGifSettings(getGifJsonFile(), defaultGif);
+        loaded->frames = cache->getFrames(getUserGif(loaded->settings->fileName), *loaded->settings);
+
+        {
+            const juce::ScopedLock lock{pendingLock};
+            pendingGif = std::move(loaded);
+        }
+        triggerAsyncUpdate();
+    }
+
+    /** Swaps in the gif from the loader thread. */
+    void handleAsyncUpdate() override {
+        std::unique_ptr<LoadedGif> loaded;
+        {
+            const juce::ScopedLock lock{pendingLock};
+            loaded = std::move(pendingGif);
+        }
+        if (loaded == nullptr) return;
+
+        settings = *loaded->settings;
+        gif = std::move(loaded->frames);
+        previousFrameIdx = currentFrameIdx = settings.idleFrameRange.getStart();
+        idleAnimation();
+        repaint();
+    }
+
+    // steps one frame, @return true when the trigger animation finished and idle started.
+    bool advanceFrame() {
+        if (isIdle) {
+            handleFrameIndex(settings.idleFrameRange);
+        } else {
+            handleFrameIndex(settings.triggerFrameRange);
+        }
+
+        // check for end of trigger
+        bool triggerMaybeCompleted = settings.bounceBack ? isReversed && !isIdle : !isReversed && !isIdle;
+        if (triggerMaybeCompleted){
+            size_t lastIndex = settings.bounceBack ? settings.triggerFrameRange.getStart() : settings.triggerFrameRange.getEnd();
+            if (currentFrameIdx == lastIndex) {
+                idleAnimation();
+                return true;
+            }
+        }
+        return false;
+    }
+
     void handleFrameIndex(const juce::Range<size_t>& range) {
         if (range.getLength() > 0) {
             if (currentFrameIdx == range.getStart()) isReversed = false;
@@ -101,95 +163,60 @@ private:
     }
 
 
-    // assumes that all necessary values have defaults from constructor already
-    GifSyncResult syncJSONData() {
-        // 1. get or create the resources required for the gif
-        auto json = getGifJsonFile();
-
-        // 2. get full settings json object
-        var rootVar = JSON::parse(json);
-        if (!rootVar.isVoid());
-        DynamicObject* rootObject = rootVar.getDynamicObject();
-        if (rootObject == nullptr) return GifSyncResult::RootNotFound;
-
-        // 3. get the gif object in question
-        auto gifVar = rootObject->getProperty(juce::Identifier{fileName});
-        jassert(!gifVar.isVoid());
-        DynamicObject* gifObject = gifVar.getDynamicObject();
-        if (gifObject == nullptr) return GifSyncResult::GifNotFound;
-
-        // 4. get the properties
-        tryAssignInt<size_t>(gifObject, "rows", rows);
-        tryAssignInt<size_t>(gifObject, "columns", columns);
-        tryAssignInt<size_t>(gifObject, "total_frames", totalAmount);
-
-        size_t idleX{idleFrameRange.getStart()}, idleY{idleFrameRange.getEnd()}, triggerX{triggerFrameRange.getStart()}, triggerY{triggerFrameRange.getEnd()};
-        tryAssignInt<size_t>(gifObject, "idle_start_frame_index", idleX);
-        tryAssignInt<size_t>(gifObject, "idle_end_frame_index", idleY);
-        tryAssignInt<size_t>(gifObject, "trigger_start_index", triggerX);
-        tryAssignInt<size_t>(gifObject, "trigger_end_index", triggerY);
-
-        idleFrameRange = juce::Range<size_t>{idleX, idleY};
-        triggerFrameRange = juce::Range<size_t>{triggerX, triggerY};
-
-        tryAssignDouble<float>(gifObject, "idle_fps", idleFPS);
-        tryAssignDouble<float>(gifObject, "trigger_fps", triggerFPS);
-
-        auto bounceVar = gifObject->getProperty(juce::Identifier{"bounce_back"});
-        if (!bounceVar.isVoid() && bounceVar.isBool()) {
-            bool value = bounceVar.operator bool();
-            bounceBack = value;
-        }
-
-        return GifSyncResult::Success;
-    }
-
-    template<typename T>
-    static void tryAssignInt(juce::DynamicObject* obj, const char* name, T& assignTo) {
-        auto var = obj->getProperty(juce::Identifier{name});
-        if (!var.isVoid() && var.isInt()) {
-            int value = var.operator int();
-            assignTo = static_cast<T>(value);
-        }
-    }
-
-    template<typename T>
-    static void tryAssignDouble(juce::DynamicObject* obj, const char* name, T& assignTo) {
-        auto var = obj->getProperty(juce::Identifier{name});
-        if (!var.isVoid() && (var.isInt() || var.isDouble() || var.isInt64())) {
-            float value = var.operator float();
-            assignTo = static_cast<T>(value);
-        }
-    }
-
     void idleAnimation(){
-        currentFrameIdx = idleFrameRange.getStart();
+        currentFrameIdx = settings.idleFrameRange.getStart();
         isIdle = true;
-        startTimer(1000.f / idleFPS);
+        restartClock();
     }
     void triggerAnimation() {
-        currentFrameIdx = triggerFrameRange.getStart();
+        currentFrameIdx = settings.triggerFrameRange.getStart();
         isIdle = false;
-        startTimer(1000.f / triggerFPS);
+        restartClock();
+    }
+    void restartClock() {
+        animationStartMs = duck::FrameScheduler::now();
+        stepsTaken = 0;
+        scheduler.startAnimating(this);
     }
 
     static void createDefaultJSON(){};
 
 private:
-    size_t rows{1}, columns{1}, totalAmount{1};
-    std::unique_ptr<PngGifFrameViewer> gif;
-    const std::string fileName;
+    struct LoadedGif {
+        std::shared_ptr<const GifSettings> settings;
+        std::shared_ptr<PngGifFrameViewer> frames;
+    };
+
+    class LoadJob : public juce::ThreadPoolJob {
+    public:
+        LoadJob(GifViewer& owner) : juce::ThreadPoolJob("H-Duck gif load"), owner(owner) {}
+        JobStatus runJob() override {
+            owner.loadActiveGif();
+            return jobHasFinished;
+        }
+    private:
+        GifViewer& owner;
+    };
+
+    static constexpr const char* defaultGif = "catgif.png";
+
+    GifSettings settings;
+    std::shared_ptr<PngGifFrameViewer> gif; // nullptr while loading, shared with other instances
     size_t currentFrameIdx = 0;
     size_t previousFrameIdx = 0;
     bool isIdle = true;
     bool isReversed = false;
     juce::ChangeBroadcaster* broadcaster = nullptr;
 
+    duck::FrameScheduler& scheduler;
+    double animationStartMs = 0;
+    int64 stepsTaken = 0;
+    static constexpr int64 maxCatchUpSteps = 8;
 
-    juce::Range<size_t> idleFrameRange = juce::Range<size_t>(0, 1);
-    juce::Range<size_t> triggerFrameRange = juce::Range<size_t>(2, 6);
-    bool bounceBack = true; /** after the trigger, will then bounce back from end to beginning before going to idle */
-    float idleFPS{1}, triggerFPS{7};
+    juce::CriticalSection pendingLock;
+    std::unique_ptr<LoadedGif> pendingGif; // handed from the loader thread to the message thread
+    juce::SharedResourcePointer<GifResourceCache> cache;
+    LoadJob loadJob{*this};
 };
 
 
@@ -0,0 +1,65 @@
+#pragma once
+#include <JuceHeader.h>
+#include "DuckValueTree.h"
+
+namespace duck {
+
+/**
+ * The steps of the trigger pattern, clicking one turns it on or off.
+ *
+ * The steps live in the tree, so edits are undoable and stored with the state. The processor only plays them
+ * while the trigger parameter uses the pattern.
+*/
+class PatternStrip : public juce::Component, public juce::SettableTooltipClient, private juce::ValueTree::Listener {
+public:
+    explicit PatternStrip(duck::vt::ValueTree& vTree)
+    : vTree(vTree)
+    {
+        vTree.addListener(this);
+        setTooltip("Steps of the trigger pattern, sixteenth notes on the host's beat grid");
+    }
+
+    ~PatternStrip() override {
+        vTree.removeListener(this);
+    }
+
+    void paint(juce::Graphics& g) override {
+        const auto steps = vTree.getPatternSteps();
+        for (int i = 0; i < dsp::pattern::amtSteps; i++) {
+            auto cell = getStepBounds(i).reduced(1.f);
+            const bool isOn = (steps >> i) & 1u;
+            const bool isBeat = i % 4 == 0;
+
+            g.setColour(isOn ? juce::Colours::red : juce::Colours::grey.withLightness(isBeat ? 0.4f : 0.3f));
+            g.fillRoundedRectangle(cell, 2.f);
+        }
+    }
+
+    void mouseDown(const juce::MouseEvent& e) override {
+        if (!e.mods.isLeftButtonDown()) return;
+        const int step = juce::jlimit(0, dsp::pattern::amtSteps - 1,
+            static_cast<int>(e.position.x / getWidth() * dsp::pattern::amtSteps));
+
+        vTree.beginTransaction(); // one undo step per click
+        vTree.setPatternSteps(vTree.getPatternSteps() ^ (1u << step));
+    }
+
+private:
+    juce::Rectangle<float> getStepBounds(int step) const {
+        const float width = getWidth() / static_cast<float>(dsp::pattern::amtSteps);
+        // a bit of space between the beats
+        const float gap = (step % 4 == 0 && step > 0) ? 2.f : 0.f;
+        return {step * width + gap, 0.f, width - gap, static_cast<float>(getHeight())};
+    }
+
+    void valueTreePropertyChanged(juce::ValueTree&, const juce::Identifier& property) override {
+        if (property == vTree.getIDFromType(Property::P_PATTERN_STEPS)) repaint();
+    }
+    void valueTreeRedirected(juce::ValueTree&) override { repaint(); }
+
+    duck::vt::ValueTree& vTree;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PatternStrip)
+};
+
+} // namespace
@@ -1,11 +1,16 @@
 #pragma once
 #include <JuceHeader.h>
+#include <atomic>
+#include <map>
 #include <string>
+#include <vector>
 
 namespace duck {
 
 /**
  * Will go from top left to bottom right.
+ *
+ * Can be shared by several viewers (see GifResourceCache), as long as they all use it from the message thread.
 */
 class PngGifFrameViewer {
 public:
@@ -15,6 +20,7 @@ public:
         if (rows < 1 || columns < 1 || totalAmount < 1) jassertfalse;
         loadedImage = ImageFileFormat::loadFrom(file);
         jassert(!loadedImage.isNull());
+        memoryUsage = getImageBytes(loadedImage);
     }
 
     const Image getFrame(size_t frameIndex) {
@@ -25,6 +31,66 @@ public:
         return loadedImage.getClippedImage(dims);
     }
 
+    /**
+     * Returns the frame resampled to the physical pixel size of fittedBounds, so it can be blitted without scaling.
+     * The frames are cached in premultiplied ARGB and only resampled again when the size or scale changes.
+     * The last few sizes are kept, so viewers of different sizes sharing this don't resample each other's frames.
+     * @param fittedBounds The area the frame is drawn in, see getFittedBounds.
+     * @param scale The physical pixel scale of the graphics context.
+    */
+    const Image& getScaledFrame(size_t frameIndex, const Rectangle<int>& fittedBounds, float scale) {
+        const int width = std::max(1, roundToInt(fittedBounds.getWidth() * scale));
+        const int height = std::max(1, roundToInt(fittedBounds.getHeight() * scale));
+
+        auto& set = getScaledSet(width, height);
+        set.lastUse = ++useCounter;
+
+        frameIndex = std::min(frameIndex, set.frames.size() - 1);
+        auto& frame = set.frames[frameIndex];
+        if (frame.isNull()) {
+            frame = Image(Image::ARGB, width, height, true);
+            Graphics g{frame};
+            g.setImageResamplingQuality(Graphics::highResamplingQuality);
+            g.drawImage(getFrame(frameIndex), frame.getBounds().toFloat());
+            memoryUsage += getImageBytes(frame);
+        }
+
+        return frame;
+    }
+
+    /** @return The bytes held by the decoded sheet and the scaled frames. Can be called from any thread. */
+    size_t getMemoryUsage() const { return memoryUsage.load(); }
+
+    /**
+     * @return The part of fittedBounds that differs between two frames, so only that has to be repainted.
+     * Compared once per pair of frames, on the source pixels.
+    */
+    Rectangle<int> getChangedArea(size_t fromFrame, size_t toFrame, const Rectangle<int>& fittedBounds) {
+        auto key = std::make_pair(std::min(fromFrame, toFrame), std::max(fromFrame, toFrame));
+        auto it = changedAreas.find(key);
+        if (it == changedAreas.end())
+            it = changedAreas.emplace(key, findChangedArea(key.first, key.second)).first;
+
+        const auto dims = getFrameDimensions().toFloat();
+        if (dims.isEmpty()) return fittedBounds;
+        const auto& area = it->second;
+        if (area.isEmpty()) return {};
+        const float sx = fittedBounds.getWidth() / dims.getWidth();
+        const float sy = fittedBounds.getHeight() / dims.getHeight();
+
+        return Rectangle<float>(fittedBounds.getX() + area.getX() * sx, fittedBounds.getY() + area.getY() * sy, area.getWidth() * sx, area.getHeight() * sy)
+            .getSmallestIntegerContainer()
+            .expanded(1)
+            .getIntersection(fittedBounds);
+    }
+
+    /** @return The largest area within bounds that keeps the frame proportions, centred. */
+    Rectangle<int> getFittedBounds(const Rectangle<int>& bounds) {
+        return RectanglePlacement(RectanglePlacement::centred)
+            .appliedTo(getFrameDimensions().toFloat(), bounds.toFloat())
+            .toNearestInt();
+    }
+
     Rectangle<int> getFrameDimensions()
     {
         const int width = loadedImage.getWidth() / columns;
@@ -33,8 +99,77 @@ public:
     }
 
 private:
+    struct ScaledSet {
+        int width = 0, height = 0;
+        std::vector<Image> frames;
+        uint32 lastUse = 0;
+    };
+
+    static constexpr size_t maxScaledSets = 4;
+
+    static size_t getImageBytes(const Image& image) {
+        return image.isNull() ? 0 : static_cast<size_t>(image.getWidth()) * static_cast<size_t>(image.getHeight()) * 4;
+    }
+
+    ScaledSet& getScaledSet(int width, int height) {
+        for (auto& set : scaledSets) {
+            if (set.width == width && set.height == height) return set;
+        }
+
+        // replace the least recently used size
+        if (scaledSets.size() >= maxScaledSets) {
+            auto oldest = std::min_element(scaledSets.begin(), scaledSets.end(), [](const ScaledSet& a, const ScaledSet& b){ return a.lastUse < b.lastUse; });
+            for (const auto& frame : oldest->frames) memoryUsage -= getImageBytes(frame);
+            scaledSets.erase(oldest);
+        }
+
+        ScaledSet set;
+        set.width = width;
+        set.height = height;
+        set.frames.resize(std::max<size_t>(totalAmount, rows * columns));
+        scaledSets.push_back(std::move(set));
+        return scaledSets.back();
+    }
+
+    /** @return The bounding box of the differing pixels between two frames, in frame pixels. */
+    Rectangle<int> findChangedArea(size_t fromFrame, size_t toFrame) {
+        auto dims = getFrameDimensions();
+        if (fromFrame == toFrame || dims.isEmpty()) return {};
+        if (fromFrame >= rows * columns || toFrame >= rows * columns) return dims;
+
+        auto frameOrigin = [this, dims](size_t frameIndex) {
+            return Point<int>(static_cast<int>(frameIndex % columns) * dims.getWidth(), static_cast<int>(frameIndex / columns) * dims.getHeight());
+        };
+        const auto a = frameOrigin(fromFrame);
+        const auto b = frameOrigin(toFrame);
+
+        const Image::BitmapData bitmap{loadedImage, Image::BitmapData::readOnly};
+        int left = dims.getWidth(), top = dims.getHeight(), right = -1, bottom = -1;
+        for (int y = 0; y < dims.getHeight(); y++) {
+            for (int x = 0; x < dims.getWidth(); x++) {
+                if (std::memcmp(bitmap.getPixelPointer(a.x + x, a.y + y), bitmap.getPixelPointer(b.x + x, b.y + y), static_cast<size_t>(bitmap.pixelStride)) != 0) {
+                    left = std::min(left, x);
+                    right = std::max(right, x);
+                    top = std::min(top, y);
+                    bottom = std::max(bottom, y);
+                }
+            }
+        }
+
+        if (right < 0) return {};
+        return Rectangle<int>::leftTopRightBottom(left, top, right + 1, bottom + 1);
+    }
+
     size_t rows, columns, totalAmount;
     Image loadedImage;
+
+    // bounding boxes of the pixels that change between two frames, keyed by (lowest, highest) frame index.
+    std::map<std::pair<size_t, size_t>, Rectangle<int>> changedAreas;
+
+    // the frames at the last requested physical sizes, resampled lazily.
+    std::vector<ScaledSet> scaledSets;
+    uint32 useCounter = 0;
+    std::atomic<size_t> memoryUsage{0};
 };
 
-}
\ No newline at end of file
+}
@@ -11,13 +11,20 @@
 //==============================================================================
 HentaiDuckEditor::HentaiDuckEditor(HentaiDuckProcessor &p)
     : AudioProcessorEditor(&p), audioProcessor(p),
-      curveDisplay(audioProcessor.vTree),
+      frameScheduler(*this),
+      curveDisplay(audioProcessor.vTree, audioProcessor.curveModel),
       lengthSliderMs(10.f, 2000.f, 50.f),
-      lookaheadSliderMs(0.f, 50.f, 0.f)
+      lookaheadSliderMs(0.f, 50.f, 0.f),
+      depthSlider(0.f, 100.f, 100.f),
+      mixSlider(0.f, 100.f, 100.f),
+      patternStrip(audioProcessor.vTree),
+      backgroundLayer([this](juce::Graphics& g){ paintBackgroundLayer(g); }),
+      outlineLayer([this](juce::Graphics& g){ paintOutlineLayer(g); })
 {
     // Make sure that before the constructor has finished, you've set the
     // editor's size to whatever you need it to be.
 
+    setOpaque(true);
     setSize(800, 500);
     setResizable(true, true);
     setResizeLimits(400, 250, 1500, 1000);
@@ -26,12 +33,22 @@ HentaiDuckEditor::HentaiDuckEditor(HentaiDuckProcessor &p)
     setupCurveDisplay();
     setupLengthSlider();
     setupLookaheadSlider();
+    setupPercentSlider(depthSlider, duck::params::ID::DEPTH, "Depth: ");
+    setupPercentSlider(mixSlider, duck::params::ID::MIX, "Mix: ");
+    setupCombineBox();
+    setupPattern();
 
     // make all visible
     addAndMakeVisible(gifViewer.get());
     addAndMakeVisible(&curveDisplay);
     addAndMakeVisible(&lengthSliderMs);
     addAndMakeVisible(&lookaheadSliderMs);
+    addAndMakeVisible(&depthSlider);
+    addAndMakeVisible(&mixSlider);
+    addAndMakeVisible(&combineBox);
+    addAndMakeVisible(&triggerBox);
+    addAndMakeVisible(&patternStrip);
+    addAndMakeVisible(&swingSlider);
 }
 
 HentaiDuckEditor::~HentaiDuckEditor()
@@ -40,6 +57,16 @@ HentaiDuckEditor::~HentaiDuckEditor()
 
 //==============================================================================
 void HentaiDuckEditor::paintOverChildren(juce::Graphics &g)
+{
+    outlineLayer.draw(g, getLocalBounds());
+}
+
+void HentaiDuckEditor::paint(juce::Graphics &g)
+{
+    backgroundLayer.draw(g, getLocalBounds());
+}
+
+void HentaiDuckEditor::paintOutlineLayer(juce::Graphics &g) const
 {
     auto bounds = curveBounds;
     g.setColour(juce::Colours::grey.withLightness(0.6f));
@@ -49,7 +76,7 @@ void HentaiDuckEditor::paintOverChildren(juce::Graphics &g)
     g.drawRoundedRectangle(bounds.getX(), bounds.getY(), bounds.getWidth(), bounds.getHeight(), 5.f, 3.f);
 }
 
-void HentaiDuckEditor::paint(juce::Graphics &g)
+void HentaiDuckEditor::paintBackgroundLayer(juce::Graphics &g) const
 {
     // (Our component is opaque, so we must completely fill the background with a solid colour)
     g.fillAll(juce::Colours::purple.withSaturation(0.5f).withBrightness(0.10f));
@@ -67,12 +94,29 @@ void HentaiDuckEditor::resized()
     auto buttonsBounds = paddedBounds.removeFromRight(paddedBounds.getWidth() * 0.3f);
     buttonsBounds.removeFromLeft(sectionPadding);
 
+    // the pattern and its swing under the curve
+    auto patternBounds = paddedBounds.removeFromBottom(24);
+    paddedBounds.removeFromBottom(componentPadding);
+    swingSlider.setBounds(patternBounds.removeFromRight(patternBounds.getWidth() / 4));
+    patternBounds.removeFromRight(componentPadding);
+    patternStrip.setBounds(patternBounds);
+
     this->sliderBounds = buttonsBounds;
     this->curveBounds = paddedBounds;
 
     curveDisplay.setBounds(paddedBounds);
-    lengthSliderMs.setBounds(buttonsBounds.removeFromBottom(buttonsBounds.getHeight()*0.5f));
-    lookaheadSliderMs.setBounds(buttonsBounds);
+    auto boxes = buttonsBounds.removeFromBottom(24);
+    triggerBox.setBounds(boxes.removeFromLeft(boxes.getWidth() / 2).withTrimmedRight(componentPadding / 2));
+    combineBox.setBounds(boxes.withTrimmedLeft(componentPadding / 2));
+    buttonsBounds.removeFromBottom(componentPadding);
+    auto topSliders = buttonsBounds.removeFromTop(buttonsBounds.getHeight()*0.5f);
+    mixSlider.setBounds(buttonsBounds.removeFromRight(buttonsBounds.getWidth()*0.5f));
+    depthSlider.setBounds(buttonsBounds);
+    lengthSliderMs.setBounds(topSliders.removeFromRight(topSliders.getWidth()*0.5f));
+    lookaheadSliderMs.setBounds(topSliders);
+
+    backgroundLayer.invalidate();
+    outlineLayer.invalidate();
 }
 
 //
@@ -92,17 +136,14 @@ void HentaiDuckEditor::setupCurveDisplay()
 {
     curveDisplay.onCurveUpdated = [this]()
     {
-        audioProcessor.updateCurveValues(curveDisplay.getNormalizedPoints());
+        audioProcessor.updateCurveValues();
     };
 
-    curveDisplay.onCurveUpdated(); // initial update
+    curveDisplay.setPlaybackSource(&audioProcessor.playbackState, &frameScheduler, &audioProcessor.sidechainTriggeredBroadcaster);
 }
 
 void HentaiDuckEditor::setupLengthSlider()
 {
-    auto &vTree = audioProcessor.vTree;
-    using prop = Property;
-
     lengthSliderMs.setValuePrefix("Length: ");
     lengthSliderMs.setValuePostfix(" ms");
     lengthSliderMs.valueToString = [this](float val) -> std::string
@@ -119,19 +160,7 @@ void HentaiDuckEditor::setupLengthSlider()
         }
         return juce::String(newVal, 2, false).toStdString();
     };
-    lengthSliderMs.onValueChanged = [this](float newVal)
-    {
-        audioProcessor.updateCurveLength(static_cast<double>(newVal));
-    };
-
-    lengthSliderMs.setValueTree(
-        &vTree,
-        vTree.getIDFromType(prop::T_LENGTH_MS).value_or("undefined"),
-        vTree.getIDFromType(prop::P_RAW_NORMALIZED_VALUE).value_or("undefined"),
-        vTree.getIDFromType(prop::P_DISPLAY_VALUE).value_or("undefined"),
-        vTree.getIDFromType(prop::P_MIN_VALUE).value_or("undefined"),
-        vTree.getIDFromType(prop::P_MAX_VALUE).value_or("undefined")
-    );
+    lengthSliderMs.setParameter(&audioProcessor.getParameterFor(duck::params::ID::LENGTH_MS));
 }
 
 void HentaiDuckEditor::setupLookaheadSlider()
@@ -152,43 +181,46 @@ void HentaiDuckEditor::setupLookaheadSlider()
         }
         return juce::String(newVal, 2, false).toStdString();
     };
-    lookaheadSliderMs.onValueChanged = [this](float newVal)
+    // every change resizes the delay and the latency, so only send it once the drag is done.
+    lookaheadSliderMs.updateTreeOnDrag = false;
+    lookaheadSliderMs.setParameter(&audioProcessor.getParameterFor(duck::params::ID::LOOKAHEAD_MS));
+}
+
+void HentaiDuckEditor::setupPercentSlider(subnite::Slider<float>& slider, duck::params::ID id, const std::string& prefix)
+{
+    slider.setValuePrefix(prefix);
+    slider.setValuePostfix(" %");
+    slider.valueToString = [](float val) -> std::string
     {
-        audioProcessor.updateLookahead(static_cast<double>(newVal));
+        return juce::String(val, 0, false).toStdString();
     };
+    slider.setParameter(&audioProcessor.getParameterFor(id));
+}
 
-    lookaheadSliderMs.updateTreeOnDrag = false;
+void HentaiDuckEditor::setupCombineBox()
+{
+    auto& parameter = audioProcessor.getParameterFor(duck::params::ID::COMBINE);
+    combineBox.addItemList(parameter.getAllValueStrings(), 1);
+    combineBox.setTooltip("How the curves of overlapping notes are combined");
+    // the attachment selects the current choice, so the items have to be there first.
+    combineAttachment = std::make_unique<juce::ComboBoxParameterAttachment>(parameter, combineBox);
+}
 
-    using prop = Property;
-    auto &vTree = audioProcessor.vTree;
-    lookaheadSliderMs.setValueTree(
-        &vTree,
-        vTree.getIDFromType(prop::T_LOOKAHEAD_MS).value_or("undefined"),
-        vTree.getIDFromType(prop::P_RAW_NORMALIZED_VALUE).value_or("undefined"),
-        vTree.getIDFromType(prop::P_DISPLAY_VALUE).value_or("undefined"),
-        vTree.getIDFromType(prop::P_MIN_VALUE).value_or("undefined"),
-        vTree.getIDFromType(prop::P_MAX_VALUE).value_or("undefined")
-    );
+void HentaiDuckEditor::setupPattern()
+{
+    auto& trigger = audioProcessor.getParameterFor(duck::params::ID::TRIGGER);
+    triggerBox.addItemList(trigger.getAllValueStrings(), 1);
+    triggerBox.setTooltip("Trigger from MIDI notes, the pattern below the curve, or both");
+    triggerAttachment = std::make_unique<juce::ComboBoxParameterAttachment>(trigger, triggerBox);
+
+    swingSlider.setSliderStyle(juce::Slider::LinearHorizontal);
+    swingSlider.setTextBoxStyle(juce::Slider::NoTextBox, false, 0, 0);
+    swingSlider.setTooltip("Swing, pushes every second step back");
+    swingAttachment = std::make_unique<juce::SliderParameterAttachment>(audioProcessor.getParameterFor(duck::params::ID::SWING), swingSlider);
 }
 
 void HentaiDuckEditor::setupGifViewer() {
-    auto json = duck::GifViewer::getGifJsonFile();
-
-    // 2. get full settings json object
-    var rootVar = JSON::parse(json);
-    if (!rootVar.isVoid());
-    DynamicObject* rootObject = rootVar.getDynamicObject();
-    if (rootObject == nullptr) 
-        gifViewer = std::make_unique<duck::GifViewer>("catgif.png", &audioProcessor.sidechainTriggeredBroadcaster);
-;
-
-    // 3. get the gif object in question
-    auto gifVar = rootObject->getProperty(juce::Identifier{"active_gif"});
-    if (!gifVar.isVoid() && gifVar.isString()) {
-        String value = gifVar.operator juce::String();
-        gifViewer = std::make_unique<duck::GifViewer>(value.toStdString(), &audioProcessor.sidechainTriggeredBroadcaster);
-    } else {
-        gifViewer = std::make_unique<duck::GifViewer>("catgif.png", &audioProcessor.sidechainTriggeredBroadcaster);
-    }
+    // reads gifs.json and decodes the sprite sheet in the background, shows up once that's done.
+    gifViewer = std::make_unique<duck::GifViewer>(frameScheduler, &audioProcessor.sidechainTriggeredBroadcaster);
     gifViewer->setBounds(getLocalBounds());
-}
\ No newline at end of file
+}
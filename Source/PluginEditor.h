@@ -13,6 +13,10 @@
 #include "Curve.h"
 #include "CustomSliders.h"
 #include "GifViewer.h"
+#include "GifResourceCache.h"
+#include "CachedLayer.h"
+#include "FrameScheduler.h"
+#include "PatternStrip.h"
 
 //==============================================================================
 /**
@@ -35,19 +39,47 @@ private:
     // This reference is provided as a quick way for your editor to
     // access the processor object that created it.
     HentaiDuckProcessor& audioProcessor;
-    
+
+    // the decoded gifs and their loader thread, shared by every open editor in the process. headless instances never make it.
+    juce::SharedResourcePointer<duck::GifResourceCache> gifCache;
+    // declared before every animated component, so it outlives them.
+    duck::FrameScheduler frameScheduler;
+
     duck::curve::CurveDisplay curveDisplay;
     subnite::Slider<float> lengthSliderMs;
     subnite::Slider<float> lookaheadSliderMs;
+    subnite::Slider<float> depthSlider;
+    subnite::Slider<float> mixSlider;
+    // how overlapping note ons combine, see duck::dsp::CombineMode.
+    juce::ComboBox combineBox;
+    std::unique_ptr<juce::ComboBoxParameterAttachment> combineAttachment;
+    // where the note ons come from, and the pattern with its swing.
+    juce::ComboBox triggerBox;
+    std::unique_ptr<juce::ComboBoxParameterAttachment> triggerAttachment;
+    duck::PatternStrip patternStrip;
+    juce::Slider swingSlider;
+    std::unique_ptr<juce::SliderParameterAttachment> swingAttachment;
+    // shows the tooltips of the boxes and the pattern.
+    juce::TooltipWindow tooltipWindow{this};
 
     juce::Rectangle<int> curveBounds;
     juce::Rectangle<int> sliderBounds;
 
     std::unique_ptr<duck::GifViewer> gifViewer;
 
+    // static layers, only rendered again when the layout or display scale changes
+    duck::CachedLayer backgroundLayer;
+    duck::CachedLayer outlineLayer;
+    void paintBackgroundLayer(juce::Graphics& g) const;
+    void paintOutlineLayer(juce::Graphics& g) const;
+
     void setupCurveDisplay();
     void setupLengthSlider();
     void setupLookaheadSlider();
+    // depth and mix, both in percent.
+    void setupPercentSlider(subnite::Slider<float>& slider, duck::params::ID id, const std::string& prefix);
+    void setupCombineBox();
+    void setupPattern();
     void setupGifViewer();
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (HentaiDuckEditor)
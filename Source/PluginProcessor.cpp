@@ -16,119 +16,265 @@
 //==============================================================================
 HentaiDuckProcessor::HentaiDuckProcessor()
 #ifndef JucePlugin_PreferredChannelConfigurations
-                       : AudioProcessor (BusesProperties()
-#if ! JucePlugin_IsMidiEffect
-#if ! JucePlugin_IsSynth
-.withInput  ("Input",  juce::AudioChannelSet::stereo(), true)
-#endif
-.withOutput ("Output", juce::AudioChannelSet::stereo(), true)
-#endif
-                       )
+                       : AudioProcessor (createBuses())
 #endif
 {
+    for (auto& amount : busAmounts)
+        amount.setCurrentAndTargetValue(1.f);
+
+    for (size_t i = 0; i < duck::params::amount; i++) {
+        auto parameter = duck::params::create(static_cast<duck::params::ID>(i));
+        parameters[i] = parameter.get();
+        parameter->addListener(this);
+        addParameter(parameter.release());
+    }
+
     if (!vTree.isValid()) vTree.create();
-    updateCurveLength(getSliderMsFromTree<double>(vTree, Property::T_LENGTH_MS, Property::P_DISPLAY_VALUE));
+    curveModel.loadFromTree(vTree);
+    patternSteps.store(vTree.getPatternSteps());
+    vTree.addListener(this);
+    updateCurveValues();
+    // nothing else sees the tree yet, so a host asking from another thread before the first edit gets the defaults.
+    updateCachedState();
+    audioThreadPoll.startTimer(100);
 }
 
 HentaiDuckProcessor::~HentaiDuckProcessor()
-{}
+{
+    audioThreadPoll.stopTimer();
+    stopTimer();
+    cancelPendingUpdate();
+    vTree.removeListener(this);
+    for (auto parameter : parameters)
+        parameter->removeListener(this);
+}
 
-void HentaiDuckProcessor::resizeCurve(size_t newSize){
-    std::lock_guard<std::mutex> lock{curveGuard};
-    curveMultiplier = std::vector<float>();
-    curveMultiplier.reserve(newSize);
-    curveMultiplier.resize(newSize);
-    std::fill(curveMultiplier.begin(), curveMultiplier.end(), 1.0f);
+juce::AudioProcessor::BusesProperties HentaiDuckProcessor::createBuses() {
+    auto buses = BusesProperties()
+#if ! JucePlugin_IsMidiEffect
+#if ! JucePlugin_IsSynth
+        .withInput  ("Input",  juce::AudioChannelSet::stereo(), true)
+#endif
+        .withOutput ("Output", juce::AudioChannelSet::stereo(), true)
+#endif
+        ;
 
-    noteStartPositions.reserve(50);
-    noteStartPositions.resize(50);
+    // stems the host can enable, ducked by the same triggers and curve as the main bus.
+    for (int bus = 2; bus <= duck::dsp::maxBuses; bus++) {
+        const auto name = "Stem " + juce::String(bus);
+        buses = buses.withInput(name, juce::AudioChannelSet::stereo(), false)
+                     .withOutput(name, juce::AudioChannelSet::stereo(), false);
+    }
+    return buses;
+}
 
-    if (newSize > 0) currentCurveIndex = newSize-1; 
+duck::params::Values HentaiDuckProcessor::getParameterValues() const {
+    duck::params::Values values{};
+    for (size_t i = 0; i < duck::params::amount; i++)
+        values[i] = getParameterValue(static_cast<duck::params::ID>(i));
+    return values;
 }
 
-void HentaiDuckProcessor::updateCurveLength(const double& ms) {
-    auto samples = static_cast<size_t>(getSampleRate() * (ms/1000));
-    resizeCurve(samples);
-    updateCurveValues(duck::curve::CurveDisplay::getTreeNormalizedPoints(vTree));
+void HentaiDuckProcessor::setParameterValues(const duck::params::Values& values) {
+    for (size_t i = 0; i < duck::params::amount; i++)
+        parameters[i]->setValueNotifyingHost(parameters[i]->convertTo0to1(values[i]));
 }
 
-void HentaiDuckProcessor::applyCurve(juce::AudioBuffer<float> &buffer) {
-    auto channels = buffer.getArrayOfWritePointers();
-    auto amtChannels = buffer.getNumChannels();
+float HentaiDuckProcessor::getParameterValue(duck::params::ID id) const {
+    const auto& parameter = getParameterFor(id);
+    return parameter.convertFrom0to1(parameter.getValue());
+}
 
-    auto guard = std::lock_guard<std::mutex>(curveGuard);
-    for (size_t sample = 0; sample < buffer.getNumSamples(); sample++) {
+void HentaiDuckProcessor::setCurveTable(const std::vector<duck::curve::Point<float>>& normalizedPoints){
+    auto table = curveTables->get(normalizedPoints);
 
-        // if this sample is a trigger position, restart the curve counter
-        for (size_t i = 0; i < amtTriggers; i++) {
-            const auto startPos = noteStartPositions[i];
-            if (sample == startPos) {
-                currentCurveIndex = 0;
-                sidechainTriggeredBroadcaster.sendChangeMessage();
-            }
-        }
+    std::lock_guard<std::mutex> lock{curveGuard};
+    curveGeneration++;
+    if (curveMultiplier != nullptr) retiredTables.emplace_back(curveGeneration, std::move(curveMultiplier));
+    curveMultiplier = std::move(table);
+    curveSettings.write({curveMultiplier->data(), curveGeneration});
+
+    // the next block reads this generation or a newer one, so nothing older is in use while no audio runs.
+    if (!audioRunning.load())
+        audioCurveGeneration.store(curveGeneration, std::memory_order_release);
+    releaseRetiredTables();
+}
 
-        for (size_t ch = 0;
-        ch < amtChannels &&
-        (currentCurveIndex < curveMultiplier.size() && currentCurveIndex >= 0)
-        && (ch < lookaheadBuffer.size())
-        ; ch++)
-        {
-            auto channel = buffer.getWritePointer(ch);
-            auto latentSample = lookaheadBuffer[ch].insertAndPop(channel[sample]);
-            latentSample *= 1-curveMultiplier[currentCurveIndex];
-            channel[sample] = latentSample;
+void HentaiDuckProcessor::releaseAllRetiredTables() {
+    std::lock_guard<std::mutex> lock{curveGuard};
+    audioCurveGeneration.store(curveGeneration, std::memory_order_release);
+    releaseRetiredTables();
+}
+
+void HentaiDuckProcessor::releaseRetiredTables() {
+    const auto seenByAudio = audioCurveGeneration.load(std::memory_order_acquire);
+    retiredTables.erase(
+        std::remove_if(retiredTables.begin(), retiredTables.end(), [seenByAudio](const auto& retired){ return retired.first <= seenByAudio; }),
+        retiredTables.end()
+    );
+}
+
+duck::dsp::BlockSettings HentaiDuckProcessor::readBlockSettings() {
+    const auto& curve = curveSettings.read();
+    audioCurveGeneration.store(curve.generation, std::memory_order_release);
+
+    duck::dsp::BlockSettings settings;
+    settings.curveTable = curve.table;
+    settings.kernels = kernels.load(std::memory_order_relaxed);
+    settings.lengthMs = getParameterValue(duck::params::ID::LENGTH_MS);
+    settings.lookaheadMs = getParameterValue(duck::params::ID::LOOKAHEAD_MS);
+    settings.depth = getParameterValue(duck::params::ID::DEPTH);
+    for (int bus = 1; bus < duck::dsp::maxBuses; bus++)
+        settings.stemDepths[static_cast<size_t>(bus - 1)] = getParameterValue(duck::params::getStemDepth(bus));
+    settings.mix = getParameterValue(duck::params::ID::MIX);
+    settings.combine = static_cast<duck::dsp::CombineMode>(juce::roundToInt(getParameterValue(duck::params::ID::COMBINE)));
+    settings.trigger = static_cast<duck::dsp::TriggerSource>(juce::roundToInt(getParameterValue(duck::params::ID::TRIGGER)));
+    settings.swing = getParameterValue(duck::params::ID::SWING) / 100.f;
+    settings.patternSteps = patternSteps.load(std::memory_order_relaxed);
+    settings.link = static_cast<duck::dsp::LinkMode>(juce::roundToInt(getParameterValue(duck::params::ID::LINK)));
+    return settings;
+}
+
+void HentaiDuckProcessor::applyCurve(juce::AudioBuffer<float> &buffer, const duck::dsp::BlockSettings& settings) {
+    const int numSamples = buffer.getNumSamples();
+    const auto amtChannels = std::min(buffer.getNumChannels(), lookahead.getNumChannels());
+    jassert(gainBufferSize >= static_cast<size_t>(numSamples));
+    if (settings.curveTable == nullptr || numSamples <= 0) return; // nothing published yet
+    float* gains = gainBuffer;
+
+    // the length only sets how fast the phase moves through the table, ramped over the block so automation doesn't jump.
+    const double phaseIncrement = 1.0 / std::max(1.0, sampleRate * settings.lengthMs / 1000.0);
+    if (lastPhaseIncrement <= 0.0) lastPhaseIncrement = phaseIncrement;
+    const double incrementStep = (phaseIncrement - lastPhaseIncrement) / numSamples;
+    double increment = lastPhaseIncrement;
+    lastPhaseIncrement = phaseIncrement;
+
+    // dry * (1 - mix) + dry * (1 - depth * curve) * mix is dry * (1 - mix * depth * curve), so both are one factor per bus.
+    bool smoothing = false;
+    for (int bus = 0; bus < amtBuses; bus++) {
+        const float depth = bus == 0 ? settings.depth : settings.stemDepths[static_cast<size_t>(bus - 1)];
+        busAmounts[static_cast<size_t>(bus)].setTargetValue(depth / 100.f * settings.mix / 100.f);
+        smoothing = smoothing || busAmounts[static_cast<size_t>(bus)].isSmoothing();
+    }
+
+    // delay every channel of every bus first, the gains don't depend on the audio.
+    const auto delay = duck::dsp::kernels::selectDelay(amtChannels, lookahead.isActive());
+    delay(lookahead, buffer.getArrayOfWritePointers(), amtChannels, numSamples);
+
+    const auto& simd = *settings.kernels;
+
+    // parked at the end with nothing to restart it, so every bus gets one gain. usually 1, which leaves it alone.
+    if (voices.isIdle() && amtTriggers == 0 && !smoothing) {
+        const float end = duck::dsp::CurveTableStore::read(settings.curveTable, 1.0);
+        float mainGain = 1.f;
+        for (int bus = 0; bus < amtBuses; bus++) {
+            const float gain = 1-busAmounts[static_cast<size_t>(bus)].getTargetValue() * end;
+            if (bus == 0) mainGain = gain;
+            if (gain == 1.f) continue;
+            const auto [first, count] = busChannels[static_cast<size_t>(bus)];
+            for (int ch = first; ch < std::min(first + count, amtChannels); ch++)
+                simd.multiplyConstant(buffer.getWritePointer(ch), gain, numSamples);
         }
-        if (currentCurveIndex < curveMultiplier.size()-1){
-            // this makes sure that the multiplier stays on the last one after the trigger.
-            currentCurveIndex++;
+
+        duck::dsp::PlaybackState state;
+        state.position = 1.f;
+        state.gain = mainGain;
+        playbackState.publish(state);
+        return;
+    }
+
+    // the curves run in segments between the note ons, every playing voice read from the table by the simd kernel.
+    // they're read at full depth once, every bus scales them by its own depth after.
+    const auto resolution = static_cast<int>(duck::dsp::CurveTableStore::resolution);
+    size_t nextTrigger = 0;
+    int sample = 0;
+    while (sample < numSamples) {
+        // start a voice for every trigger at this sample
+        while (nextTrigger < amtTriggers && noteStartPositions[nextTrigger] <= sample) {
+            voices.trigger(settings.combine);
+            sidechainTriggeredBroadcaster.sendChangeMessage();
+            nextTrigger++;
         }
+        const int end = nextTrigger < amtTriggers ? std::min(numSamples, noteStartPositions[nextTrigger]) : numSamples;
+        const int length = end - sample;
+
+        voices.render(simd, settings.curveTable, resolution, settings.combine, increment, incrementStep,
+                      gains + sample, voiceScratch, length);
+
+        increment += length * incrementStep;
+        sample = end;
     }
 
-    // now delay them
-    // for (size_t channel = 0; channel < numChannels && channel < lookaheadBuffer.size(); channel++){
-    //     auto chPtr = buffer.getWritePointer(channel);
-    //     for (size_t sample = 0; sample < buffer.getNumSamples() && sample < lookaheadBuffer[channel].size(); sample++) {
-    //         auto latentSample = lookaheadBuffer[channel].insertAndPop(chPtr[sample]);
-    //         chPtr[sample] = latentSample;
-    //     }
+    float lowestGain = 1.f;
+    for (int bus = 0; bus < amtBuses; bus++) {
+        auto& amount = busAmounts[static_cast<size_t>(bus)];
+        const auto [first, count] = busChannels[static_cast<size_t>(bus)];
+        const int last = std::min(first + count, amtChannels);
+
+        if (amount.isSmoothing()) {
+            // while the depth ramps, the gains of the bus are made per sample first
+            for (int i = 0; i < numSamples; i++)
+                busGains[i] = 1-amount.getNextValue() * (1-gains[i]);
+            for (int ch = first; ch < last; ch++)
+                simd.multiply(buffer.getWritePointer(ch), busGains, numSamples);
+            if (bus == 0) lowestGain = juce::FloatVectorOperations::findMinimum(busGains, numSamples);
+        } else {
+            const float depth = amount.getTargetValue();
+            for (int ch = first; ch < last; ch++)
+                simd.multiplyWithDepth(buffer.getWritePointer(ch), gains, depth, numSamples);
+            if (bus == 0) lowestGain = 1-depth * (1-juce::FloatVectorOperations::findMinimum(gains, numSamples));
+        }
+    }
 
-    // }
+    duck::dsp::PlaybackState state;
+    state.position = static_cast<float>(voices.getNewestPhase());
+    state.gain = std::min(1.f, lowestGain);
+    playbackState.publish(state);
 }
 
-void HentaiDuckProcessor::updateCurveValues(const std::vector<duck::curve::Point<float>>& normalizedPoints) {
-    auto lock = std::lock_guard<std::mutex>(curveGuard);
+bool HentaiDuckProcessor::setKernels(const juce::String& name) {
+    auto set = name.isEmpty() ? &duck::dsp::simd::getDefaultKernels() : duck::dsp::simd::findKernels(name);
+    if (set == nullptr) return false;
+    kernels.store(set);
+    return true;
+}
 
-    for (size_t i = 0; i < curveMultiplier.size(); i++){
-        float normX = i / static_cast<float>(curveMultiplier.size()-1);
-        curveMultiplier[i] = duck::curve::CurveDisplay::getCurveAtNormalized(normX, normalizedPoints);
-    }
+void HentaiDuckProcessor::updateCurveValues() {
+    const auto curve = curveModel.get();
+    setCurveTable(curve->points);
 }
 
 void HentaiDuckProcessor::updateLookahead(double ms) {
     jassert(ms >= 0);
-    auto samples = static_cast<size_t>(this->sampleRate * (ms/1000));
+    lookahead.setDelay(juce::roundToInt(this->sampleRate * (ms/1000)));
+    appliedLookaheadMs = static_cast<float>(ms);
+    publishLatency(lookahead.getDelay());
+}
 
-    if (lookaheadBuffer.size() > 0) {
+void HentaiDuckProcessor::publishLatency(int samples) {
+    pendingLatency.store(samples);
+    // the audio thread leaves it to the poll, setLatencySamples tells the host right away.
+    if (juce::MessageManager::existsAndIsCurrentThread() && samples != getLatencySamples())
+        setLatencySamples(samples);
+}
 
-        if (samples > lookaheadBuffer[0].capacity()){
-            // make new and bigger buffers.
-            // TODO: 
-            bool kanker = true;
-        }
-        // set size to match samples
-        for (auto& buf : lookaheadBuffer) {
-            buf.setRelativeSize(samples);
-        }
-    }
+void HentaiDuckProcessor::handleAsyncUpdate() {
+    loadPendingState();
+}
 
-    setLatencySamples(samples);
+void HentaiDuckProcessor::pollAudioThreadChanges() {
+    const auto samples = pendingLatency.load();
+    if (samples != getLatencySamples()) setLatencySamples(samples);
+    if (linkChanged.exchange(false)) updateLink();
+    // a parameter changed on another thread, serialized once it settles like the edits.
+    if (stateDirty.exchange(false) && !isTimerRunning())
+        startTimer(500);
 }
 
 template <typename T>
 T HentaiDuckProcessor::getSliderMsFromTree(const duck::vt::ValueTree& tree, Property sliderTreeID, Property sliderPropertyID) {
-    const auto sliderTree = tree.getRoot().getChildWithName(tree.getIDFromType(sliderTreeID).value_or("undefined"));
-    double displayValueFromTree = sliderTree.getProperty(tree.getIDFromType(sliderPropertyID).value_or("undefined"));
+    const auto sliderTree = tree.getRoot().getChildWithName(tree.getIDFromType(sliderTreeID));
+    double displayValueFromTree = sliderTree.getProperty(tree.getIDFromType(sliderPropertyID));
     return static_cast<T>(displayValueFromTree);
 }
 
@@ -140,49 +286,241 @@ T HentaiDuckProcessor::getSliderMsFromTree(const duck::vt::ValueTree& tree, Prop
 
 
 
-void HentaiDuckProcessor::busSettingsChanged(size_t sampleRate, size_t samplesPerBlock, size_t channels) {
-    jassert(channels >= 1);
-
-    // lookahead buffer setup
-    lookaheadBuffer = std::vector<RingBuffer<float>>();
-    lookaheadBuffer.reserve(channels);
-    for (int i = 0; i < channels; i++) {
-        const auto latencyMs = vTree.isValid() ? getSliderMsFromTree<double>(vTree, Property::T_LOOKAHEAD_MS, Property::P_DISPLAY_VALUE) : 0.0;
-        const auto maxLatencyMs = vTree.isValid() ? getSliderMsFromTree<double>(vTree, Property::T_LOOKAHEAD_MS, Property::P_MAX_VALUE) : 1000.0;
-
-        const size_t size = sampleRate * (latencyMs/1000.0);
-        auto newRing = RingBuffer<float>(sampleRate * (maxLatencyMs/1000.0)); // 10 safety padding, should actually just be the max amt of latency.
-        newRing.setRelativeSize(size);
-        lookaheadBuffer.push_back(newRing);
+void HentaiDuckProcessor::busSettingsChanged(size_t sampleRate) {
+    // the lines are laid out by prepareToPlay for its rate. a new rate without it only clamps the delay, nothing is laid out here.
+    if (sampleRate != lookaheadSampleRate) {
+        const auto latencyMs = getParameterValue(duck::params::ID::LOOKAHEAD_MS);
+        lookahead.reset(static_cast<double>(sampleRate), juce::roundToInt(sampleRate * (latencyMs/1000.0)));
+        lookaheadSampleRate = sampleRate;
+        appliedLookaheadMs = latencyMs;
+        publishLatency(lookahead.getDelay());
+        for (auto& amount : busAmounts)
+            amount.reset(static_cast<double>(sampleRate), 0.02);
     }
 
-    // resize curve multipliers and fill, set latency too.
-    if (vTree.isValid())
-    {
-        updateCurveLength(getSliderMsFromTree<double>(vTree, Property::T_LENGTH_MS, Property::P_DISPLAY_VALUE));
-        updateLookahead(getSliderMsFromTree<double>(vTree, Property::T_LOOKAHEAD_MS, Property::P_DISPLAY_VALUE));
-    }
-    else
-    {
-        resizeCurve(sampleRate / 2); // if tree is not valid
-        setLatencySamples(0);
+    // the channels of every enabled bus pair in the process buffer, the outputs mirror the inputs.
+    amtBuses = 0;
+    for (int bus = 0; bus < std::min(getBusCount(true), duck::dsp::maxBuses); bus++) {
+        const auto layoutBus = getBus(true, bus);
+        const int count = layoutBus != nullptr && layoutBus->isEnabled() ? layoutBus->getNumberOfChannels() : 0;
+        busChannels[static_cast<size_t>(bus)] = {count > 0 ? getChannelIndexInProcessBlockBuffer(true, bus, 0) : 0, count};
+        amtBuses = bus + 1;
     }
 }
 
+void HentaiDuckProcessor::prepareArena(size_t channels, size_t samplesPerBlock, double sampleRate) {
+    // the curve table isn't in here, it's shared between every instance with the same curve (see CurveTableStore).
+    arena.clear();
+    const auto gainOffset = arena.reserve<float>(samplesPerBlock);
+    const auto busGainOffset = arena.reserve<float>(samplesPerBlock);
+    const auto scratchOffset = arena.reserve<float>(samplesPerBlock);
+    const auto triggerOffset = arena.reserve<int>(maxTriggersPerBlock);
+    const auto lineOffset = arena.reserve<float>(lookahead.getRequiredSamples(static_cast<int>(channels), sampleRate));
+    arena.allocate();
+
+    gainBuffer = arena.get<float>(gainOffset);
+    gainBufferSize = samplesPerBlock;
+    busGains = arena.get<float>(busGainOffset);
+    voiceScratch = arena.get<float>(scratchOffset);
+    noteStartPositions = arena.get<int>(triggerOffset);
+    amtTriggers = 0;
+    lookahead.prepare(arena.get<float>(lineOffset), static_cast<int>(channels), sampleRate);
+}
+
 void HentaiDuckProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
 {
     // Use this method as the place to do any pre-playback
     // initialisation that you need..
 
-    // assuming stereo channels
-    int channels = getMainBusNumInputChannels();
-    busSettingsChanged(sampleRate, samplesPerBlock, channels); // didn't actually check if they changed, so this can be used as initializer too.
+    // from here on retired tables wait for the audio thread again. set before the first block, which reads the newest generation.
+    audioRunning.store(true);
+
+    int channels = getTotalNumInputChannels();
+    this->sampleRate = static_cast<size_t>(sampleRate);
+    this->samplesPerBlock = static_cast<size_t>(std::max(samplesPerBlock, 1));
+    this->numChannels = static_cast<size_t>(channels);
+    lookaheadSampleRate = 0; // starts clean, without fading from what played before
+    // everything the audio thread touches is laid out here, with lines for the channels of the enabled buses at this rate.
+    // hosts prepare again after changing either, longer blocks than promised are processed in chunks of this size,
+    // so processBlock never allocates.
+    prepareArena(static_cast<size_t>(std::max(channels, 1)), this->samplesPerBlock, sampleRate);
+    busSettingsChanged(this->sampleRate);
 }
 
 void HentaiDuckProcessor::processBlock(juce::AudioBuffer<float> &buffer, juce::MidiBuffer &midiMessages)
+{
+    juce::ScopedNoDenormals noDenormals;
+    const auto settings = beginBlock(buffer);
+
+    const auto playHead = getPlayHead();
+    const auto position = playHead != nullptr ? playHead->getPosition() : juce::Optional<juce::AudioPlayHead::PositionInfo>{};
+
+    const int numSamples = buffer.getNumSamples();
+    const int chunkSize = static_cast<int>(gainBufferSize);
+    if (chunkSize <= 0) return; // not prepared
+    if (numSamples <= chunkSize) {
+        processChunk(buffer, midiMessages, 0, position.hasValue() ? &*position : nullptr, settings);
+        return;
+    }
+
+    // the host sent more than it promised in prepareToPlay, the arena is only that big.
+    for (int start = 0; start < numSamples; start += chunkSize) {
+        // refers to the channels of buffer, without allocating for up to 32 of them
+        juce::AudioBuffer<float> chunk{buffer.getArrayOfWritePointers(), buffer.getNumChannels(), start, std::min(chunkSize, numSamples - start)};
+        if (position.hasValue()) {
+            const auto chunkPosition = advancePosition(*position, start, static_cast<double>(sampleRate));
+            processChunk(chunk, midiMessages, start, &chunkPosition, settings);
+        }
+        else {
+            processChunk(chunk, midiMessages, start, nullptr, settings);
+        }
+    }
+}
+
+void HentaiDuckProcessor::processChunk(juce::AudioBuffer<float> &buffer, const juce::MidiBuffer &midiMessages, int offset,
+                                       const juce::AudioPlayHead::PositionInfo* position, const duck::dsp::BlockSettings& settings)
+{
+    const int numSamples = buffer.getNumSamples();
+
+    // find positions to start the ducker
+    amtTriggers = 0;
+
+    if (settings.trigger != duck::dsp::TriggerSource::PATTERN) {
+        for (auto it = midiMessages.findNextSamplePosition(offset); it != midiMessages.cend(); ++it)
+        {
+            const auto metadata = *it;
+            if (metadata.samplePosition >= offset + numSamples) break;
+            auto message = metadata.getMessage();
+            if (message.isNoteOn(true))
+            {
+                jassert(amtTriggers < maxTriggersPerBlock);
+                if (amtTriggers >= maxTriggersPerBlock) break;
+                noteStartPositions[amtTriggers] = metadata.samplePosition - offset;
+                amtTriggers++;
+            }
+        }
+    }
+
+    bool addedOutOfOrder = false;
+    if (position != nullptr) {
+        if (settings.trigger != duck::dsp::TriggerSource::MIDI) {
+            const auto amtMidiTriggers = amtTriggers;
+            addPatternTriggers(settings, *position, numSamples);
+            addedOutOfOrder = amtMidiTriggers > 0 && amtTriggers > amtMidiTriggers;
+        }
+        if (linkTriggers(settings, *position, numSamples))
+            addedOutOfOrder = true;
+    }
+    // applyCurve goes through them in order
+    if (addedOutOfOrder)
+        std::sort(noteStartPositions, noteStartPositions + amtTriggers);
+
+    applyCurve(buffer, settings);
+}
+
+juce::AudioPlayHead::PositionInfo HentaiDuckProcessor::advancePosition(juce::AudioPlayHead::PositionInfo position, int samples, double sampleRate) {
+    const double seconds = samples / sampleRate;
+    if (const auto time = position.getTimeInSamples()) position.setTimeInSamples(*time + samples);
+    if (const auto time = position.getTimeInSeconds()) position.setTimeInSeconds(*time + seconds);
+
+    const auto ppq = position.getPpqPosition();
+    const auto bpm = position.getBpm();
+    if (!ppq.hasValue() || !bpm.hasValue()) return position;
+
+    double next = *ppq + seconds * *bpm / 60.0;
+    // a loop that wraps within the block wraps the later chunks too
+    const auto loop = position.getLoopPoints();
+    if (position.getIsLooping() && loop.hasValue() && loop->ppqEnd > loop->ppqStart && next >= loop->ppqEnd)
+        next = loop->ppqStart + std::fmod(next - loop->ppqStart, loop->ppqEnd - loop->ppqStart);
+    position.setPpqPosition(next);
+    return position;
+}
+
+bool HentaiDuckProcessor::linkTriggers(const duck::dsp::BlockSettings& settings, const juce::AudioPlayHead::PositionInfo& position, int numSamples) {
+    auto link = activeLink.load(std::memory_order_acquire);
+    const auto time = position.getTimeInSamples();
+    if (link == nullptr || !time.hasValue()) return false;
+
+    if (settings.link == duck::dsp::LinkMode::SEND) {
+        for (size_t i = 0; i < amtTriggers; i++)
+            link->send(*time + noteStartPositions[i]);
+        return false;
+    }
+    if (settings.link != duck::dsp::LinkMode::RECEIVE) return false;
+
+    // a sender that runs after this instance in the same cycle is a block late, those start at the first sample.
+    const auto amtOwnTriggers = amtTriggers;
+    link->receive(*time, numSamples, numSamples, [this](int sample) {
+        if (amtTriggers < maxTriggersPerBlock) noteStartPositions[amtTriggers++] = sample;
+    });
+    return amtOwnTriggers > 0 && amtTriggers > amtOwnTriggers;
+}
+
+void HentaiDuckProcessor::updateLink() {
+    const auto mode = static_cast<duck::dsp::LinkMode>(juce::roundToInt(getParameterValue(duck::params::ID::LINK)));
+    if (mode == duck::dsp::LinkMode::OFF) {
+        activeLink.store(nullptr, std::memory_order_release);
+        return;
+    }
+
+    const auto channel = static_cast<size_t>(juce::jlimit(0, duck::params::amtLinkChannels - 1,
+                                                          juce::roundToInt(getParameterValue(duck::params::ID::LINK_CHANNEL))));
+    auto& link = links[channel];
+    if (link == nullptr) link = std::make_unique<duck::dsp::TriggerLink>("link-" + juce::String(channel + 1));
+    activeLink.store(link->isValid() ? link.get() : nullptr, std::memory_order_release);
+}
+
+void HentaiDuckProcessor::parameterValueChanged(int index, float) {
+    const auto id = static_cast<duck::params::ID>(index);
+    if (id == duck::params::ID::LINK || id == duck::params::ID::LINK_CHANNEL) {
+        if (juce::MessageManager::existsAndIsCurrentThread()) updateLink();
+        else linkChanged.store(true);
+    }
+    treeChanged();
+}
+
+void HentaiDuckProcessor::addPatternTriggers(const duck::dsp::BlockSettings& settings, const juce::AudioPlayHead::PositionInfo& position, int numSamples) {
+    if (!position.getIsPlaying()) return;
+    const auto ppq = position.getPpqPosition();
+    const auto bpm = position.getBpm();
+    if (!ppq.hasValue() || !bpm.hasValue()) return;
+
+    duck::dsp::pattern::Transport transport;
+    transport.ppq = *ppq;
+    transport.bpm = *bpm;
+    transport.isLooping = position.getIsLooping();
+    if (const auto loop = position.getLoopPoints()) {
+        transport.loopStartPpq = loop->ppqStart;
+        transport.loopEndPpq = loop->ppqEnd;
+    }
+
+    duck::dsp::pattern::forEachStep(transport, static_cast<double>(sampleRate), numSamples, settings.patternSteps, settings.swing,
+        [this, numSamples](int sample) {
+            if (amtTriggers >= maxTriggersPerBlock) return;
+            noteStartPositions[amtTriggers++] = std::clamp(sample, 0, numSamples - 1);
+        });
+}
+
+void HentaiDuckProcessor::processBlockBypassed(juce::AudioBuffer<float> &buffer, juce::MidiBuffer &midiMessages)
 {
     juce::ignoreUnused(midiMessages);
     juce::ScopedNoDenormals noDenormals;
+    beginBlock(buffer);
+
+    // the dry signal still goes through the lookahead, so bypassing doesn't move it against the reported latency.
+    amtTriggers = 0;
+    voices.stopAll();
+    const auto amtChannels = std::min(buffer.getNumChannels(), lookahead.getNumChannels());
+    const auto delay = duck::dsp::kernels::selectDelay(amtChannels, lookahead.isActive());
+    delay(lookahead, buffer.getArrayOfWritePointers(), amtChannels, buffer.getNumSamples());
+
+    duck::dsp::PlaybackState state;
+    state.position = 1.f;
+    state.gain = 1.f;
+    playbackState.publish(state);
+}
+
+duck::dsp::BlockSettings HentaiDuckProcessor::beginBlock(juce::AudioBuffer<float> &buffer) {
     auto totalNumInputChannels = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
 
@@ -191,28 +529,17 @@ void HentaiDuckProcessor::processBlock(juce::AudioBuffer<float> &buffer, juce::M
         buffer.clear(i, 0, buffer.getNumSamples());
     }
 
-    if (totalNumInputChannels != this->numChannels || buffer.getNumSamples() != this->samplesPerBlock || getSampleRate() != sampleRate){
-        this->samplesPerBlock = buffer.getNumSamples();
+    // longer blocks than prepared are chunked by processBlock, only the buses and the rate matter here.
+    if (totalNumInputChannels != this->numChannels || getSampleRate() != sampleRate){
         this->numChannels = totalNumInputChannels;
         this->sampleRate = getSampleRate();
-        busSettingsChanged(this->sampleRate, this->samplesPerBlock, this->numChannels);
-    }
-
-    // find positions to start the ducker
-    amtTriggers = 0;
-
-    for (const auto metadata : midiMessages)
-    {
-        auto message = metadata.getMessage();
-        if (message.isNoteOn(true))
-        {
-            jassert(amtTriggers < noteStartPositions.size());
-            noteStartPositions[amtTriggers] = metadata.samplePosition;
-            amtTriggers++;
-        }
+        busSettingsChanged(this->sampleRate);
     }
 
-    applyCurve(buffer);
+    const auto settings = readBlockSettings();
+    if (settings.lookaheadMs != appliedLookaheadMs)
+        updateLookahead(settings.lookaheadMs);
+    return settings;
 }
 
 const juce::String HentaiDuckProcessor::getName() const
@@ -285,6 +612,8 @@ void HentaiDuckProcessor::releaseResources()
 {
     // When playback stops, you can use this as an opportunity to free up any
     // spare memory, etc.
+    audioRunning.store(false);
+    releaseAllRetiredTables();
 }
 
 #ifndef JucePlugin_PreferredChannelConfigurations
@@ -305,6 +634,15 @@ bool HentaiDuckProcessor::isBusesLayoutSupported(const BusesLayout &layouts) con
 #if !JucePlugin_IsSynth
     if (layouts.getMainOutputChannelSet() != layouts.getMainInputChannelSet())
         return false;
+
+    // every stem is a stereo pair or off, and its output matches its input. the host picks how many.
+    if (layouts.inputBuses.size() != layouts.outputBuses.size() || layouts.inputBuses.size() > duck::dsp::maxBuses)
+        return false;
+    for (int bus = 1; bus < layouts.inputBuses.size(); bus++) {
+        const auto& input = layouts.inputBuses.getReference(bus);
+        if (input != layouts.outputBuses.getReference(bus)) return false;
+        if (!input.isDisabled() && input != juce::AudioChannelSet::stereo()) return false;
+    }
 #endif
 
     return true;
@@ -327,33 +665,113 @@ juce::AudioProcessorEditor *HentaiDuckProcessor::createEditor()
 //==============================================================================
 void HentaiDuckProcessor::getStateInformation(juce::MemoryBlock &destData)
 {
-    juce::ignoreUnused(destData);
     // You should use this method to store your parameters in the memory block.
+    // hosts ask for this on every autosave and undo point, so unchanged state is just a copy of the cache.
+    // the tree is only read on the message thread, other threads get it as of the last settled edit.
+    if (juce::MessageManager::existsAndIsCurrentThread()) {
+        loadPendingState();
+        updateCachedState();
+    }
+    const juce::ScopedLock lock{stateLock};
+    destData = cachedState;
 
-    juce::MemoryOutputStream stream(destData, true);
+    // the parameters are atomics, so those are always live. not over a restored state that isn't loaded yet, they're still the old ones.
+    if (!juce::MessageManager::existsAndIsCurrentThread() && !hasPendingState)
+        duck::vt::state::writeParameters(getParameterValues(), destData);
+}
+
+void HentaiDuckProcessor::updateCachedState()
+{
+    const auto generation = treeGeneration.load();
+    if (generation == cachedStateGeneration) return;
+
+    // serialized outside the lock, it only guards the cache itself.
+    juce::MemoryBlock state;
     if (vTree.isValid())
-    {
-        vTree.writeToStream(stream);
+        duck::vt::state::write(vTree, getParameterValues(), state);
 
-#ifdef CMAKE_DEBUG
-        vTree.createXML("C:/Dev/Juce Projects/HentaiDuck/getStateOutputTree.xml");
-#endif
-    }
+    const juce::ScopedLock lock{stateLock};
+    cachedState.swapWith(state);
+    cachedStateGeneration = generation;
+}
+
+void HentaiDuckProcessor::treeChanged()
+{
+    treeGeneration++;
+    if (juce::MessageManager::existsAndIsCurrentThread())
+        startTimer(500); // restarts while editing, fires once the edits settle
+    else
+        stateDirty.store(true); // automation, the poll starts the timer on the message thread
+}
+
+void HentaiDuckProcessor::valueTreePropertyChanged(juce::ValueTree&, const juce::Identifier& property)
+{
+    if (property == vTree.getIDFromType(Property::P_PATTERN_STEPS))
+        patternSteps.store(vTree.getPatternSteps());
+    treeChanged();
+}
+
+void HentaiDuckProcessor::timerCallback()
+{
+    stopTimer();
+    loadPendingState(); // before serializing, the cache already holds the pending state
+    updateCachedState();
 }
 
 void HentaiDuckProcessor::setStateInformation(const void *data, int sizeInBytes)
 {
-    juce::ignoreUnused(data, sizeInBytes);
     // You should use this method to restore your parameters from this memory block, whose contents will have been created by the getStateInformation() call.
 
-    vTree.copyFrom(data, sizeInBytes);
+    // the tree and the curve model belong to the message thread, a state from any other thread is loaded there.
+    if (!juce::MessageManager::existsAndIsCurrentThread()) {
+        {
+            const juce::ScopedLock lock{stateLock};
+            pendingState.replaceAll(data, static_cast<size_t>(std::max(sizeInBytes, 0)));
+            hasPendingState = true;
+            // a host that stores right after restoring gets back what it restored
+            cachedState = pendingState;
+        }
+        triggerAsyncUpdate();
+        return;
+    }
+    loadState(data, sizeInBytes);
+}
+
+void HentaiDuckProcessor::loadPendingState()
+{
+    juce::MemoryBlock state;
+    {
+        const juce::ScopedLock lock{stateLock};
+        if (!hasPendingState) return;
+        state.swapWith(pendingState);
+        hasPendingState = false;
+    }
+    loadState(state.getData(), static_cast<int>(state.getSize()));
+}
+
+void HentaiDuckProcessor::loadState(const void *data, int sizeInBytes)
+{
+    // binary state first, otherwise it's a ValueTree blob from an older version
+    if (const auto parameterValues = duck::vt::state::read(data, static_cast<size_t>(std::max(sizeInBytes, 0)), vTree)) {
+        setParameterValues(*parameterValues);
+    }
+    else {
+        vTree.copyFrom(data, sizeInBytes);
+
+        // those kept the length and lookahead in their slider trees
+        auto values = duck::params::getDefaults();
+        const auto& root = vTree.getRoot();
+        if (root.getChildWithName(vTree.getIDFromType(Property::T_LENGTH_MS)).isValid())
+            values[static_cast<size_t>(duck::params::ID::LENGTH_MS)] = getSliderMsFromTree<float>(vTree, Property::T_LENGTH_MS, Property::P_DISPLAY_VALUE);
+        if (root.getChildWithName(vTree.getIDFromType(Property::T_LOOKAHEAD_MS)).isValid())
+            values[static_cast<size_t>(duck::params::ID::LOOKAHEAD_MS)] = getSliderMsFromTree<float>(vTree, Property::T_LOOKAHEAD_MS, Property::P_DISPLAY_VALUE);
+        setParameterValues(values);
+    }
     if (!vTree.isValid())
         vTree.create(); // this shouldn't happen, unless there were breaking changes in an update
-    updateCurveLength(getSliderMsFromTree<double>(vTree, Property::T_LENGTH_MS, Property::P_DISPLAY_VALUE));
-
-#ifdef CMAKE_DEBUG
-    vTree.createXML("C:/Dev/Juce Projects/HentaiDuck/setStateOutputTree.xml");
-#endif
+    curveModel.loadFromTree(vTree);
+    patternSteps.store(vTree.getPatternSteps());
+    updateCurveValues();
 }
 
 //==============================================================================
@@ -8,14 +8,27 @@
 
 #pragma once
 #include <JuceHeader.h>
+#include <array>
 #include <mutex>
+#include <utility>
 #include "Curve.h"
 #include "DuckValueTree.h"
-#include "RingBuffer.hpp"
+#include "DuckStateFormat.h"
+#include "DuckParameters.h"
+#include "PlaybackState.h"
+#include "CurveTableStore.h"
+#include "TripleBuffer.h"
+#include "BlockSettings.h"
+#include "LookaheadDelay.h"
+#include "Arena.h"
+#include "DelayKernels.h"
+#include "KernelDispatch.h"
+#include "VoicePool.h"
+#include "TriggerLink.h"
 
 //==============================================================================
 
-class HentaiDuckProcessor  : public juce::AudioProcessor
+class HentaiDuckProcessor  : public juce::AudioProcessor, private juce::ValueTree::Listener, private juce::AudioProcessorParameter::Listener, private juce::Timer, private juce::AsyncUpdater
 #if JucePlugin_Enable_ARA
 , public juce::AudioProcessorARAExtension
 #endif
@@ -34,6 +47,8 @@ public:
 #endif
 
     void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    // delays the dry signal by the lookahead, so bypassing keeps the latency the host compensates for.
+    void processBlockBypassed (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
 
     //==============================================================================
     juce::AudioProcessorEditor* createEditor() override;
@@ -55,48 +70,182 @@ public:
     void changeProgramName (int index, const juce::String& newName) override;
 
     //==============================================================================
+    // safe on any thread. off the message thread the parameters are live, but the curve and pattern are the ones
+    // cached once edits settled, so a save made within half a second of a curve edit can miss it.
     void getStateInformation (juce::MemoryBlock& destData) override;
     void setStateInformation (const void* data, int sizeInBytes) override;
 
     //==============================================================================
-    // updates the multiplier values in curveMultiplier to match the points.
-    void updateCurveValues(const std::vector<duck::curve::Point<float>>& normalizedPoints);
-    // changes the size of curveMultiplier (matches sampleRate) and applies the values from the tree.
-    void updateCurveLength(const double& ms);
-    // updates the size of the lookaheadBuffer and sets latency accordingly.
-    void updateLookahead(double ms);
+    // updates the multiplier values in curveMultiplier to match the curve model.
+    void updateCurveValues();
+    // forces the kernels of one instruction set ("scalar", "sse2", "avx2", "avx512" or "neon"), for benchmarks and tests.
+    // an empty name goes back to the one picked for this cpu. false if this cpu can't run it. any thread, picked up by the next block.
+    bool setKernels(const juce::String& name);
+    const char* getKernelName() const { return kernels.load()->name; }
+    // the host parameter for id, lives as long as the processor.
+    juce::RangedAudioParameter& getParameterFor(duck::params::ID id) const { return *parameters[static_cast<size_t>(id)]; }
+    // the plain value of the parameter for id, the index for choices.
+    float getParameterValue(duck::params::ID id) const;
 
     // contains all info that is stored and restored from the plugin data block
     duck::vt::ValueTree vTree{};
+    // the curve, edited by the editor. synced into vTree when an edit is done.
+    duck::curve::CurveModel curveModel{};
     juce::ChangeBroadcaster sidechainTriggeredBroadcaster{};
+    // curve position and gain reduction of the last block, polled by the editor.
+    duck::dsp::PlaybackStatePublisher playbackState{};
 private:
-  // list of multiplier for the curve
-  std::vector<float> curveMultiplier;
-  // save us from threads (each access of curve multiplier)
+  // the main bus pair and the stem bus pairs, disabled until the host enables them.
+  static BusesProperties createBuses();
+
+  // owned by the AudioProcessor, indexed by duck::params::ID.
+  std::array<juce::RangedAudioParameter*, duck::params::amount> parameters{};
+  // the plain value of every parameter.
+  duck::params::Values getParameterValues() const;
+  // sets every parameter and tells the host, used when loading a state.
+  void setParameterValues(const duck::params::Values& values);
+
+  // list of multiplier for the curve, shared with other instances that have the same curve. never written to.
+  std::shared_ptr<const duck::dsp::CurveTableStore::Table> curveMultiplier;
+  juce::SharedResourcePointer<duck::dsp::CurveTableStore> curveTables;
+  // only serializes the threads that publish a curve, the audio thread never takes it.
   std::mutex curveGuard;
-  // last read multiplier index
-  int currentCurveIndex = 0;
-
+  // the published curve, the audio thread only sees the table pointer.
+  duck::dsp::TripleBuffer<duck::dsp::CurveSettings> curveSettings;
+  uint64_t curveGeneration = 0;
+  // the newest generation the audio thread picked up, older tables can't be in use anymore.
+  std::atomic<uint64_t> audioCurveGeneration{0};
+  // between prepareToPlay and releaseResources. while it's false no block can hold a table, so every retired one can go.
+  std::atomic<bool> audioRunning{false};
+  // marks every published generation as seen, only while no audio is running. takes curveGuard.
+  void releaseAllRetiredTables();
+  // replaced tables with the generation that replaced them, kept alive until the audio thread moved past that.
+  std::vector<std::pair<uint64_t, std::shared_ptr<const duck::dsp::CurveTableStore::Table>>> retiredTables;
+  void releaseRetiredTables();
+  // a curve per note on, overlapping ones combined by the combine parameter.
+  duck::dsp::VoicePool voices;
+  // the phase of every voice moves by this per sample, 1 / curve length in samples.
+  double lastPhaseIncrement = 0.0;
+
+  // the delay lines, gains and note starts, all in one block laid out by prepareArena.
+  duck::dsp::Arena arena;
+  // lays the arena out for channels and blocks of samplesPerBlock at sampleRate, and points the state into it. clears all of it.
+  void prepareArena(size_t channels, size_t samplesPerBlock, double sampleRate);
+  // finds the triggers of the samples of buffer, which start at offset in midiMessages, and ducks it. position is already moved to offset.
+  void processChunk(juce::AudioBuffer<float>& buffer, const juce::MidiBuffer& midiMessages, int offset,
+                    const juce::AudioPlayHead::PositionInfo* position, const duck::dsp::BlockSettings& settings);
+  // position, samples later at the same tempo.
+  static juce::AudioPlayHead::PositionInfo advancePosition(juce::AudioPlayHead::PositionInfo position, int samples, double sampleRate);
+
+  // more note ons in one block than this are dropped.
+  static constexpr size_t maxTriggersPerBlock = 128;
   size_t amtTriggers = 0;
-  std::vector<size_t> noteStartPositions;
-
-  std::vector<RingBuffer<float>> lookaheadBuffer;
-
-  // changes the size of the curveMultiplier vector.
-  void resizeCurve(size_t newSize);
-
+  int* noteStartPositions = nullptr;
+
+  // the steps of the trigger pattern, copied from the tree on the message thread.
+  std::atomic<uint32_t> patternSteps{duck::dsp::pattern::defaultSteps};
+  // adds the enabled pattern steps in the block to the triggers, from the host's position and tempo.
+  void addPatternTriggers(const duck::dsp::BlockSettings& settings, const juce::AudioPlayHead::PositionInfo& position, int numSamples);
+
+  // the rings of the link channels this instance used, opened on the message thread and kept until it's gone.
+  std::array<std::unique_ptr<duck::dsp::TriggerLink>, duck::params::amtLinkChannels> links;
+  // the ring of the selected channel, nullptr while the link is off or couldn't be opened.
+  std::atomic<duck::dsp::TriggerLink*> activeLink{nullptr};
+  // opens the selected link channel, on the message thread.
+  void updateLink();
+  // sends the triggers of the block to the link, or adds the ones received from it. @return If any were added.
+  bool linkTriggers(const duck::dsp::BlockSettings& settings, const juce::AudioPlayHead::PositionInfo& position, int numSamples);
+
+  // preallocated for the longest lookahead, fades between delays.
+  duck::dsp::LookaheadDelay lookahead{duck::params::get(duck::params::ID::LOOKAHEAD_MS).maxValue};
+  // the sample rate the delay was reset for, 0 forces a reset.
+  size_t lookaheadSampleRate = 0;
+  // the lookahead the delay and latency are set to, changed when the parameter moves.
+  float appliedLookaheadMs = -1.f;
+  // fades the delay to ms and reports the new latency.
+  void updateLookahead(double ms);
+  // the latency to report, set on the audio thread and handed to the host by pollAudioThreadChanges.
+  std::atomic<int> pendingLatency{0};
+  void publishLatency(int samples);
+  // loads a state restored from another thread, on the message thread.
+  void handleAsyncUpdate() override;
+
+  // set by parameter changes on other threads, often the audio thread, which can't post messages. picked up by the poll.
+  std::atomic<bool> linkChanged{false};
+  std::atomic<bool> stateDirty{false};
+  // hands the latency to the host, opens the link channel and schedules serializing the changes from other threads,
+  // on the message thread.
+  void pollAudioThreadChanges();
+  juce::TimedCallback audioThreadPoll{[this]() { pollAudioThreadChanges(); }};
+
+  // the simd kernels the next block runs with.
+  std::atomic<const duck::dsp::simd::KernelSet*> kernels{&duck::dsp::simd::getDefaultKernels()};
+
+  // the gain of every sample in the block, filled by the curve and applied to all channels at once.
+  float* gainBuffer = nullptr;
+  size_t gainBufferSize = 0;
+  // the gains of one bus while its depth ramps, and where each voice is read to before it's combined.
+  float* busGains = nullptr;
+  float* voiceScratch = nullptr;
+  // depth * mix of every bus, smoothed so automating them doesn't click.
+  std::array<juce::SmoothedValue<float>, duck::dsp::maxBuses> busAmounts;
+  // the first channel and amount of channels of every bus in the process buffer, see busSettingsChanged.
+  std::array<std::pair<int, int>, duck::dsp::maxBuses> busChannels{};
+  int amtBuses = 1;
+
+  // gets the table for the points from the store and publishes it to the audio thread.
+  void setCurveTable(const std::vector<duck::curve::Point<float>>& normalizedPoints);
+
+  // clears the unused outputs, follows bus changes and returns the settings for the block.
+  duck::dsp::BlockSettings beginBlock(juce::AudioBuffer<float> &buffer);
+  // reads the published curve and the parameters, once per block. a host can't change a parameter during one processBlock call,
+  // so reading them more often wouldn't follow automation any closer. the smoothing is per block: applyCurve ramps the length
+  // from the last block to this one, and busAmounts glide depth * mix towards the new values.
+  duck::dsp::BlockSettings readBlockSettings();
   // need length since it might be triggered more than once before it ends
-  void applyCurve(juce::AudioBuffer<float> &buffer);
+  void applyCurve(juce::AudioBuffer<float> &buffer, const duck::dsp::BlockSettings& settings);
 
   template <typename T>
   static T getSliderMsFromTree(const duck::vt::ValueTree& tree, Property sliderTreeID, Property sliderPropertyID);
 
 
 
+  // the serialized state, only written again when the tree changed since. see getStateInformation.
+  // written on the message thread only, the tree isn't safe to read anywhere else.
+  juce::MemoryBlock cachedState;
+  uint64_t cachedStateGeneration = 0; // message thread only
+  std::atomic<uint64_t> treeGeneration{1};
+  // guards cachedState, hosts may copy it from any thread.
+  juce::CriticalSection stateLock;
+  // serializes into cachedState if it's out of date, on the message thread.
+  void updateCachedState();
+  // a state the host restored from another thread, loaded by handleAsyncUpdate. guarded by stateLock.
+  juce::MemoryBlock pendingState;
+  bool hasPendingState = false;
+  // loads pendingState if there is one, on the message thread.
+  void loadPendingState();
+  // replaces the tree, curve and parameters with the state in data, on the message thread.
+  void loadState(const void* data, int sizeInBytes);
+
+  // any change to the tree or a parameter makes the cached state out of date.
+  void treeChanged();
+  void valueTreePropertyChanged(juce::ValueTree&, const juce::Identifier& property) override;
+  void valueTreeChildAdded(juce::ValueTree&, juce::ValueTree&) override { treeChanged(); }
+  void valueTreeChildRemoved(juce::ValueTree&, juce::ValueTree&, int) override { treeChanged(); }
+  void valueTreeChildOrderChanged(juce::ValueTree&, int, int) override { treeChanged(); }
+  void valueTreeRedirected(juce::ValueTree&) override { treeChanged(); }
+  // can be called on any thread, off the message thread it only sets the flags for pollAudioThreadChanges.
+  void parameterValueChanged(int index, float) override;
+  void parameterGestureChanged(int, bool) override {}
+  // serializes the state once edits have settled, so the host doesn't have to wait for it.
+  void timerCallback() override;
+
   size_t sampleRate = 48000;
-  size_t samplesPerBlock = 512;
+  size_t samplesPerBlock = 512; // the prepared block size, processBlock works in chunks of at most this
   size_t numChannels = 2;
-  void busSettingsChanged(size_t sampleRate, size_t samplesPerBlock, size_t channels);
+  // follows the enabled buses and resets the delay for a new rate. never allocates, the arena is laid out by prepareToPlay
+  // for the buses enabled then. channels the host enables without preparing again aren't delayed.
+  void busSettingsChanged(size_t sampleRate);
   //==============================================================================
   JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(HentaiDuckProcessor)
 };
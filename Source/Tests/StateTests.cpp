@@ -0,0 +1,108 @@
+/**
+ * @file StateTests.cpp
+ * @author Subnite
+ * @brief states saved by older versions load with the settings they were saved with.
+ *
+ */
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+
+namespace duck::tests
+{
+    class StateTests : public juce::UnitTest
+    {
+    public:
+        StateTests() : juce::UnitTest("Older states", "H-Duck") {}
+
+        void runTest() override
+        {
+            // before the combine parameter a retrigger restarted the curve, which is latest.
+            beginTest("a legacy ValueTree state plays latest");
+            expectLoadsLatest(createLegacyState());
+
+            beginTest("a version 1 state plays latest");
+            expectLoadsLatest(createBinaryState(1));
+
+            beginTest("a version 2 state without the combine parameter plays latest");
+            expectLoadsLatest(createBinaryState(2));
+
+            beginTest("a stored combine mode is kept");
+            HentaiDuckProcessor processor;
+            setCombine(processor, duck::dsp::CombineMode::MULTIPLY);
+            juce::MemoryBlock state;
+            processor.getStateInformation(state);
+
+            HentaiDuckProcessor restored;
+            restored.setStateInformation(state.getData(), static_cast<int>(state.getSize()));
+            expectEquals(getCombine(restored), static_cast<int>(duck::dsp::CombineMode::MULTIPLY));
+        }
+
+    private:
+        void expectLoadsLatest(const juce::MemoryBlock& state)
+        {
+            HentaiDuckProcessor processor;
+            // not the default, so loading has to set it
+            setCombine(processor, duck::dsp::CombineMode::DEEPEST);
+            processor.setStateInformation(state.getData(), static_cast<int>(state.getSize()));
+            expectEquals(getCombine(processor), static_cast<int>(duck::dsp::CombineMode::LATEST));
+        }
+
+        static void setCombine(HentaiDuckProcessor& processor, duck::dsp::CombineMode mode)
+        {
+            auto& parameter = processor.getParameterFor(duck::params::ID::COMBINE);
+            parameter.setValueNotifyingHost(parameter.convertTo0to1(static_cast<float>(static_cast<int>(mode))));
+        }
+
+        static int getCombine(const HentaiDuckProcessor& processor)
+        {
+            return juce::roundToInt(processor.getParameterValue(duck::params::ID::COMBINE));
+        }
+
+        // the tree blob every version before the binary format stored.
+        static juce::MemoryBlock createLegacyState()
+        {
+            duck::vt::ValueTree tree;
+            tree.create();
+            juce::MemoryBlock state;
+            juce::MemoryOutputStream stream{state, false};
+            tree.writeToStream(stream);
+            return state;
+        }
+
+        // the binary layout of version 1 or 2, see DuckStateFormat.h. version 2 stores the four parameters it had.
+        static juce::MemoryBlock createBinaryState(juce::uint16 version)
+        {
+            juce::MemoryBlock state;
+            juce::MemoryOutputStream stream{state, false};
+            stream.writeInt(static_cast<int>(duck::vt::state::magic));
+            stream.writeShort(static_cast<short>(version));
+            stream.writeShort(0);
+            stream.writeInt(2); // points
+
+            if (version == 1) {
+                // display, min, max and normalized value of the length and lookahead sliders
+                for (const double value : {300.0, 10.0, 2000.0, 0.5, 0.0, 0.0, 50.0, 0.0})
+                    stream.writeDouble(value);
+            }
+            else {
+                stream.writeInt(4); // length, lookahead, depth and mix
+                for (const float value : {300.f, 0.f, 100.f, 100.f})
+                    stream.writeFloat(value);
+            }
+
+            for (const float x : {0.f, 1.f}) {
+                stream.writeFloat(x);
+                stream.writeFloat(1.f - x); // y
+                stream.writeFloat(0.f);     // power
+                stream.writeFloat(10.f);    // max absolute power
+                stream.writeFloat(10.f);    // size
+            }
+            stream.flush();
+            return state;
+        }
+    };
+
+    static StateTests stateTests;
+
+} // namespace
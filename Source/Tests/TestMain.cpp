@@ -0,0 +1,23 @@
+/**
+ * @file TestMain.cpp
+ * @author Subnite
+ * @brief runs every juce::UnitTest in the H-Duck category, the exit code is the amount of failed tests.
+ *
+ */
+
+#include <JuceHeader.h>
+
+int main()
+{
+    // the processor starts timers and async updates, those need a message manager. this thread is its message thread.
+    const juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::UnitTestRunner runner;
+    runner.setAssertOnFailure(false);
+    runner.runTestsInCategory("H-Duck");
+
+    int failures = 0;
+    for (int i = 0; i < runner.getNumResults(); i++)
+        failures += runner.getResult(i)->failures;
+    return failures;
+}